@@ -29,13 +29,100 @@
 #define LIBRERTOS_GUARD_U32 0xFA57C0DEUL
 #endif
 
+#if (LIBRERTOS_DELAY_WHEEL != 0)
+/* Delay wheel slot of a tick. */
+#define DELAY_WHEEL_SLOT(tick) \
+        (&OSstate.DelayWheel[(tick_t)(tick) & (LIBRERTOS_DELAY_WHEEL - 1U)])
+#endif
+
 struct libreRtosState_t OSstate;
 
+#if (LIBRERTOS_DELAY_WHEEL == 0 && LIBRERTOS_MONOTONIC_TICK == 0)
 static void _OS_tickInvertBlockedTasksLists(void);
+#endif
+static tick_t _OS_tickNextWork(tick_t ticks);
+static void _OS_tickUnblockTask(struct task_t* task);
 static void _OS_tickUnblockTimedoutTasks(void);
+static void _OS_taskDelayInsert(struct taskListNode_t* node, tick_t tickToWakeup);
+static void _OS_taskDelayUntilTick(tick_t tickNow, tick_t tickToWakeup);
+#if (LIBRERTOS_DELAY_WHEEL != 0)
+static void _OS_delayWheelUpdateNext(void);
+#endif
 static void _OS_tickUnblockPendingReadyTasks(void);
 static void _OS_schedulerReal(void);
 static void _OS_scheduleTask(struct task_t*const task);
+static void _OS_taskSetReady(struct task_t*const task);
+static void _OS_taskSetNotReady(struct task_t*const task);
+static struct task_t* _OS_taskGetReady(priority_t priority);
+#if (LIBRERTOS_QUEUESET != 0)
+static void _OS_taskRemoveSetNodes(struct task_t* task);
+#endif
+#if (LIBRERTOS_PRIORITY_INHERITANCE != 0)
+static void _OS_taskRemovePendingMutex(struct task_t* task);
+#endif
+
+#if (LIBRERTOS_READY_BITMAP != 0)
+
+#ifndef LIBRERTOS_CLZ
+/* Portable count leading zeros. Used when projdefs.h does not define
+ LIBRERTOS_CLZ(x) (usually a compiler builtin or an instruction). */
+#define LIBRERTOS_CLZ(x) _OS_clz(x)
+
+/* Count leading zeros of a non-zero ready bitmap word. */
+static uint8_t _OS_clz(readyBitmap_t x)
+{
+    uint8_t n = 0;
+
+    if((x & 0xFFFF0000UL) == 0)
+    {
+        n = (uint8_t)(n + 16);
+        x <<= 16;
+    }
+    if((x & 0xFF000000UL) == 0)
+    {
+        n = (uint8_t)(n + 8);
+        x <<= 8;
+    }
+    if((x & 0xF0000000UL) == 0)
+    {
+        n = (uint8_t)(n + 4);
+        x <<= 4;
+    }
+    if((x & 0xC0000000UL) == 0)
+    {
+        n = (uint8_t)(n + 2);
+        x <<= 2;
+    }
+    if((x & 0x80000000UL) == 0)
+    {
+        n = (uint8_t)(n + 1);
+    }
+
+    return n;
+}
+
+#endif /* LIBRERTOS_CLZ */
+
+/* Highest priority with a ready task, LIBRERTOS_NO_TASK_RUNNING if there is
+ none. Must be called with interrupts disabled. */
+static priority_t _OS_readyHighestPriority(void)
+{
+    int8_t word;
+
+    for(word = LIBRERTOS_BITMAP_WORDS - 1; word >= 0; --word)
+    {
+        readyBitmap_t bits = OSstate.ReadyBitmap[word];
+        if(bits != 0)
+        {
+            return (priority_t)(word * LIBRERTOS_BITMAP_BITS +
+                    (LIBRERTOS_BITMAP_BITS - 1) - LIBRERTOS_CLZ(bits));
+        }
+    }
+
+    return LIBRERTOS_NO_TASK_RUNNING;
+}
+
+#endif /* LIBRERTOS_READY_BITMAP */
 
 /** Initialize OS. Must be called before any other OS function. */
 void OS_init(void)
@@ -56,22 +143,72 @@ void OS_init(void)
 
     OSstate.Tick = 0U;
     OSstate.DelayedTicks = 0U;
-    OSstate.BlockedTaskList_NotOverflowed = &OSstate.BlockedTaskList1;
-    OSstate.BlockedTaskList_Overflowed = &OSstate.BlockedTaskList2;
-    OS_listHeadInit(&OSstate.BlockedTaskList1);
-    OS_listHeadInit(&OSstate.BlockedTaskList2);
+
+    #if (LIBRERTOS_DELAY_WHEEL == 0)
+    {
+        OSstate.BlockedTaskList_NotOverflowed = &OSstate.BlockedTaskList1;
+        OS_listHeadInit(&OSstate.BlockedTaskList1);
+
+        #if (LIBRERTOS_MONOTONIC_TICK == 0)
+        {
+            OSstate.BlockedTaskList_Overflowed = &OSstate.BlockedTaskList2;
+            OS_listHeadInit(&OSstate.BlockedTaskList2);
+        }
+        #endif
+    }
+    #else
+    {
+        for(i = 0; i < LIBRERTOS_DELAY_WHEEL; ++i)
+        {
+            OS_listHeadInit(&OSstate.DelayWheel[i]);
+        }
+        OSstate.DelayWheelLength = 0;
+        OSstate.DelayWheelNext = 0U;
+    }
+    #endif
 
     for(i = 0; i < LIBRERTOS_MAX_PRIORITY; ++i)
     {
-        OSstate.Task[i] = NULL;
+        #if (LIBRERTOS_READY_LISTS == 0)
+        {
+            OSstate.Task[i] = NULL;
+        }
+        #else
+        {
+            OS_listHeadInit(&OSstate.ReadyList[i]);
+        }
+        #endif
+    }
+
+    #if (LIBRERTOS_READY_BITMAP != 0)
+    {
+        for(i = 0; i < LIBRERTOS_BITMAP_WORDS; ++i)
+        {
+            OSstate.ReadyBitmap[i] = 0;
+        }
     }
+    #endif
 
     #if (LIBRERTOS_SOFTWARETIMERS != 0)
     {
         OSstate.TaskTimerLastRun = 0;
         /* OSstate.TaskTimerTCB is initialized when calling OS_timerTaskCreate(). */
-        OSstate.TimerIndex = (struct taskListNode_t*)&OSstate.TimerList;
-        OS_listHeadInit(&OSstate.TimerList);
+        #if (LIBRERTOS_TIMER_WHEEL == 0)
+        {
+            OSstate.TimerIndex = (struct taskListNode_t*)&OSstate.TimerList;
+            OS_listHeadInit(&OSstate.TimerList);
+        }
+        #else
+        {
+            for(i = 0; i < LIBRERTOS_TIMER_WHEEL; ++i)
+            {
+                OS_listHeadInit(&OSstate.TimerWheel[i]);
+            }
+            OSstate.TimerWheelLength = 0;
+            OSstate.TimerWheelNext = 0U;
+            OS_listHeadInit(&OSstate.TimerExpiredList);
+        }
+        #endif
         OS_listHeadInit(&OSstate.TimerUnorderedList);
     }
     #endif
@@ -98,6 +235,8 @@ void OS_start(void)
     OS_schedulerUnlock();
 }
 
+#if (LIBRERTOS_DELAY_WHEEL == 0 && LIBRERTOS_MONOTONIC_TICK == 0)
+
 /* Invert blocked tasks lists. Called by unblock timedout tasks function. */
 static void _OS_tickInvertBlockedTasksLists(void)
 {
@@ -106,6 +245,8 @@ static void _OS_tickInvertBlockedTasksLists(void)
     OSstate.BlockedTaskList_Overflowed = temp;
 }
 
+#endif /* LIBRERTOS_DELAY_WHEEL && LIBRERTOS_MONOTONIC_TICK */
+
 /** Increment OS tick. Called by the tick interrupt (defined by the
  user). */
 void OS_tick(void)
@@ -120,6 +261,151 @@ void OS_tick(void)
     OS_schedulerUnlock();
 }
 
+/** Increment OS tick by a number of ticks at once. Called by the tick interrupt
+ (defined by the user) in tickless mode, after the processor has slept for
+ ticks ticks. See OS_getTicksToWakeup(). */
+void OS_tickAdvance(tick_t ticks)
+{
+    OS_schedulerLock();
+
+    OSstate.DelayedTicks = (tick_t)(OSstate.DelayedTicks + ticks);
+
+    /* Scheduler unlock has work todo. */
+    OSstate.SchedulerUnlockTodo = 1;
+
+    OS_schedulerUnlock();
+}
+
+/** Get the number of ticks until the next task or timer wakes up.
+
+ Tickless idle: call it in the main loop after OS_scheduler(). The tick
+ interrupt can be stopped for the returned number of ticks; the elapsed ticks
+ must then be given to the OS with OS_tickAdvance().
+
+ @return Zero if the OS has work to do now, MAX_DELAY if there is no task or
+ timer waiting for a timeout, the number of ticks to the next wakeup otherwise.
+ */
+tick_t OS_getTicksToWakeup(void)
+{
+    tick_t ticks = MAX_DELAY;
+    CRITICAL_VAL();
+
+    OS_schedulerLock();
+    CRITICAL_ENTER();
+
+    if(     OSstate.SchedulerUnlockTodo != 0 ||
+            OSstate.DelayedTicks != 0 ||
+            OSstate.PendingReadyTaskList.Length != 0)
+    {
+        /* Ticks or ready tasks to be processed. */
+        ticks = 0;
+    }
+    else
+    {
+        #if (LIBRERTOS_READY_BITMAP != 0)
+        {
+            if(_OS_readyHighestPriority() != LIBRERTOS_NO_TASK_RUNNING)
+            {
+                /* Ready task. */
+                ticks = 0;
+            }
+        }
+        #else
+        {
+            priority_t priority;
+            for(priority = 0; priority < LIBRERTOS_MAX_PRIORITY; ++priority)
+            {
+                if(_OS_taskGetReady(priority) != NULL)
+                {
+                    /* Ready task. */
+                    ticks = 0;
+                    break;
+                }
+            }
+        }
+        #endif
+
+        #if (LIBRERTOS_DELAY_WHEEL == 0)
+        {
+            /* Blocked tasks. The not overflowed list wakes up first. */
+            struct taskHeadList_t* list = OSstate.BlockedTaskList_NotOverflowed;
+
+            #if (LIBRERTOS_MONOTONIC_TICK == 0)
+            {
+                if(list->Length == 0)
+                {
+                    list = OSstate.BlockedTaskList_Overflowed;
+                }
+            }
+            #endif
+
+            if(list->Length != 0)
+            {
+                tick_t ticksToWakeup = (tick_t)(list->Head->Value - OSstate.Tick);
+                if(ticksToWakeup < ticks)
+                {
+                    ticks = ticksToWakeup;
+                }
+            }
+        }
+        #else
+        {
+            /* Blocked tasks. Constant time, the earliest wakeup is kept by the
+             delay wheel. It may be earlier than the real one (the task was
+             removed), then the OS wakes up once for nothing. */
+            if(OSstate.DelayWheelLength != 0)
+            {
+                tick_t ticksToWakeup = (tick_t)(OSstate.DelayWheelNext - OSstate.Tick);
+                if(ticksToWakeup != 0 && ticksToWakeup < ticks)
+                {
+                    ticks = ticksToWakeup;
+                }
+            }
+        }
+        #endif
+
+        #if (LIBRERTOS_SOFTWARETIMERS != 0 && LIBRERTOS_TIMER_WHEEL == 0)
+        {
+            /* Running timers. TimerIndex points to the next timer to run;
+             the ones before it run after the tick overflows. */
+            struct taskListNode_t* node = OSstate.TimerIndex;
+            if(node == (struct taskListNode_t*)&OSstate.TimerList)
+            {
+                node = OSstate.TimerList.Head;
+            }
+            if(OSstate.TimerUnorderedList.Length != 0)
+            {
+                /* Timers to be ordered by the timer task. */
+                ticks = 0;
+            }
+            else if(node != (struct taskListNode_t*)&OSstate.TimerList)
+            {
+                tick_t ticksToWakeup = (tick_t)(node->Value - OSstate.Tick);
+                if(ticksToWakeup < ticks)
+                {
+                    ticks = ticksToWakeup;
+                }
+            }
+        }
+        #elif (LIBRERTOS_SOFTWARETIMERS != 0)
+        {
+            /* The timer task is blocked until the first timer in the wheel
+             expires, so the blocked tasks above already account for it. */
+            if(OSstate.TimerUnorderedList.Length != 0)
+            {
+                /* Timers to be inserted into the wheel by the timer task. */
+                ticks = 0;
+            }
+        }
+        #endif
+    }
+
+    CRITICAL_EXIT();
+    OS_schedulerUnlock();
+
+    return ticks;
+}
+
 /** Schedule a task. Called by scheduler. */
 static void _OS_scheduleTask(struct task_t*const task)
 {
@@ -160,6 +446,21 @@ static void _OS_scheduleTask(struct task_t*const task)
 
     OSstate.CurrentTCB = currentTask;
 
+    #if (LIBRERTOS_READY_LISTS != 0)
+    {
+        /* Task ran to completion. If it is still ready move it to the end of
+         its ready list, so the other tasks with the same priority run in
+         turn. */
+        struct taskListNode_t* node = &task->NodeReady;
+        struct taskHeadList_t* list = node->List;
+        if(list != NULL && list->Tail != node)
+        {
+            OS_listRemove(node);
+            OS_listInsertAfter(list, list->Tail, node);
+        }
+    }
+    #endif
+
     #if (LIBRERTOS_STATISTICS != 0)
     {
         stattime_t now = US_systemRunTime();
@@ -216,13 +517,40 @@ static void _OS_schedulerReal(void)
                     LIBRERTOS_NO_TASK_RUNNING : OSstate.CurrentTCB->Priority);
             priority_t priority;
 
+            #if (LIBRERTOS_READY_BITMAP != 0)
+            {
+                /* Atomically find the highest priority ready task. */
+                INTERRUPTS_DISABLE();
+                priority = _OS_readyHighestPriority();
+                if(priority > currentTaskPriority)
+                {
+                    /* Higher priority task ready. */
+
+                    #if (LIBRERTOS_PREEMPTION != 0 && LIBRERTOS_PREEMPT_LIMIT > 0)
+                    {
+                        /* Schedule only if preemption limit allows it. */
+                        if(     priority >= LIBRERTOS_PREEMPT_LIMIT ||
+                                currentTaskPriority == LIBRERTOS_NO_TASK_RUNNING)
+                        {
+                            task = _OS_taskGetReady(priority);
+                        }
+                    }
+                    #else /* LIBRERTOS_PREEMPTION && LIBRERTOS_PREEMPT_LIMIT */
+                    {
+                        task = _OS_taskGetReady(priority);
+                    }
+                    #endif /* LIBRERTOS_PREEMPTION && LIBRERTOS_PREEMPT_LIMIT */
+                }
+                INTERRUPTS_ENABLE();
+            }
+            #else /* LIBRERTOS_READY_BITMAP */
             for(    priority = LIBRERTOS_MAX_PRIORITY - 1;
                     priority > currentTaskPriority;
                     --priority)
             {
                 /* Atomically test TaskState. */
                 INTERRUPTS_DISABLE();
-                if(OSstate.Task[priority] != NULL)
+                if(_OS_taskGetReady(priority) != NULL)
                 {
                     /* Higher priority task ready. */
 
@@ -232,12 +560,12 @@ static void _OS_schedulerReal(void)
                         if(     priority >= LIBRERTOS_PREEMPT_LIMIT ||
                                 currentTaskPriority == LIBRERTOS_NO_TASK_RUNNING)
                         {
-                            task = OSstate.Task[priority];
+                            task = _OS_taskGetReady(priority);
                         }
                     }
                     #else /* LIBRERTOS_PREEMPTION && LIBRERTOS_PREEMPT_LIMIT */
                     {
-                        task = OSstate.Task[priority];
+                        task = _OS_taskGetReady(priority);
                     }
                     #endif /* LIBRERTOS_PREEMPTION && LIBRERTOS_PREEMPT_LIMIT */
 
@@ -246,6 +574,7 @@ static void _OS_schedulerReal(void)
                 }
                 INTERRUPTS_ENABLE();
             }
+            #endif /* LIBRERTOS_READY_BITMAP */
         }
 
         if(task != NULL)
@@ -282,81 +611,247 @@ void OS_schedulerLock(void)
     ++OSstate.SchedulerLock;
 }
 
-/* Unblock tasks that have timedout (process OS ticks). Called by scheduler
- unlock function. */
-static void _OS_tickUnblockTimedoutTasks(void)
+/* Number of ticks to advance, up to ticks, to reach the next tick with work to
+ do: the first blocked task timeout or the tick counter overflow (invert blocked
+ tasks lists). Called by scheduler unlock function. */
+static tick_t _OS_tickNextWork(tick_t ticks)
 {
-    /* Unblock tasks that have timed-out. */
+    #if (LIBRERTOS_DELAY_WHEEL == 0)
+    {
+        struct taskHeadList_t* list = OSstate.BlockedTaskList_NotOverflowed;
+
+        #if (LIBRERTOS_MONOTONIC_TICK == 0)
+        {
+            tick_t ticksToOverflow = (tick_t)(0U - OSstate.Tick);
+            if(ticksToOverflow != 0 && ticksToOverflow < ticks)
+            {
+                ticks = ticksToOverflow;
+            }
+        }
+        #endif
 
-    if(OSstate.Tick == 0)
+        if(list->Length != 0)
+        {
+            tick_t ticksToWakeup = (tick_t)(list->Head->Value - OSstate.Tick);
+            if(ticksToWakeup < ticks)
+            {
+                ticks = ticksToWakeup;
+            }
+        }
+    }
+    #else
     {
-        _OS_tickInvertBlockedTasksLists();
+        /* Earliest wakeup in the wheel. If the wheel is empty there is no work
+         to do. Zero ticks to the earliest wakeup is a whole turn of the tick
+         counter. */
+        if(OSstate.DelayWheelLength != 0)
+        {
+            tick_t ticksToWakeup = (tick_t)(OSstate.DelayWheelNext - OSstate.Tick);
+            if(ticksToWakeup != 0 && ticksToWakeup < ticks)
+            {
+                ticks = ticksToWakeup;
+            }
+        }
     }
+    #endif
+
+    return ticks;
+}
 
-    while(  OSstate.BlockedTaskList_NotOverflowed->Length != 0 &&
-            OSstate.BlockedTaskList_NotOverflowed->Head->Value == OSstate.Tick)
+/* Unblock a task that has timedout. Called by unblock timedout tasks
+ function. */
+static void _OS_tickUnblockTask(struct task_t* task)
+{
+    /* Remove from blocked list. */
+    OS_listRemove(&task->NodeDelay);
+
+    #if (LIBRERTOS_DELAY_WHEEL != 0)
     {
-        struct task_t* task = (struct task_t*)OSstate.BlockedTaskList_NotOverflowed->Head->Owner;
+        --OSstate.DelayWheelLength;
+    }
+    #endif
 
-        /* Remove from blocked list. */
-        OS_listRemove(&task->NodeDelay);
+    INTERRUPTS_DISABLE();
 
-        INTERRUPTS_DISABLE();
+    task->State = TASKSTATE_READY;
 
-        task->State = TASKSTATE_READY;
+    /* Remove from event list. */
+    if(task->NodeEvent.List != NULL)
+    {
+        OS_listRemove(&task->NodeEvent);
+    }
 
-        /* Remove from event list. */
-        if(task->NodeEvent.List != NULL)
+    #if (LIBRERTOS_QUEUESET != 0)
+    {
+        /* Timed out waiting for a queue set. */
+        if(task->PendingSet != NULL)
         {
-            OS_listRemove(&task->NodeEvent);
+            _OS_taskRemoveSetNodes(task);
         }
+    }
+    #endif
 
-        OSstate.Task[task->Priority] = task;
+    #if (LIBRERTOS_TASK_NOTIFY != 0)
+    {
+        /* Timed out waiting for a notification. */
+        if(task->NotifyState == TASKNOTIFY_WAITING)
+        {
+            task->NotifyState = TASKNOTIFY_NONE;
+        }
+    }
+    #endif
 
-        #if (LIBRERTOS_PREEMPTION != 0)
+    #if (LIBRERTOS_PRIORITY_INHERITANCE != 0)
+    {
+        /* Timed out waiting for a mutex. */
+        if(task->PendingMutex != NULL)
         {
-            #if (LIBRERTOS_PREEMPT_LIMIT > 0)
-            if(task->Priority >= LIBRERTOS_PREEMPT_LIMIT)
-            {
-            #endif
+            _OS_taskRemovePendingMutex(task);
+        }
+    }
+    #endif
 
-                /* Inside critical section. We can read CurrentTCB directly. */
-                if(     OSstate.CurrentTCB == NULL ||
-                        task->Priority > OSstate.CurrentTCB->Priority)
-                {
-                    OSstate.HigherReadyTask = 1;
-                }
+    _OS_taskSetReady(task);
 
-            #if (LIBRERTOS_PREEMPT_LIMIT > 0)
+    #if (LIBRERTOS_PREEMPTION != 0)
+    {
+        #if (LIBRERTOS_PREEMPT_LIMIT > 0)
+        if(task->Priority >= LIBRERTOS_PREEMPT_LIMIT)
+        {
+        #endif
+
+            /* Inside critical section. We can read CurrentTCB directly. */
+            if(     OSstate.CurrentTCB == NULL ||
+                    task->Priority > OSstate.CurrentTCB->Priority)
+            {
+                OSstate.HigherReadyTask = 1;
             }
-            #endif
-        }
-        #endif /* LIBRERTOS_PREEMPTION */
 
-        INTERRUPTS_ENABLE();
+        #if (LIBRERTOS_PREEMPT_LIMIT > 0)
+        }
+        #endif
     }
+    #endif /* LIBRERTOS_PREEMPTION */
+
+    INTERRUPTS_ENABLE();
 }
 
-/* Unblock pending ready tasks. Called by scheduler unlock function. */
-static void _OS_tickUnblockPendingReadyTasks(void)
+/* Unblock tasks that have timedout (process OS ticks). Called by scheduler
+ unlock function. */
+static void _OS_tickUnblockTimedoutTasks(void)
 {
-    INTERRUPTS_DISABLE();
-    while(OSstate.PendingReadyTaskList.Length != 0)
-    {
-        struct task_t* task = (struct task_t*)OSstate.PendingReadyTaskList.Head->Owner;
-
-        /* Remove from pending ready list. */
-        OS_listRemove(&task->NodeEvent);
+    /* Unblock tasks that have timed-out. */
 
-        #if (LIBRERTOS_PREEMPTION != 0)
+    #if (LIBRERTOS_DELAY_WHEEL == 0)
+    {
+        #if (LIBRERTOS_MONOTONIC_TICK == 0)
         {
-            #if (LIBRERTOS_PREEMPT_LIMIT > 0)
-            if(task->Priority >= LIBRERTOS_PREEMPT_LIMIT)
+            if(OSstate.Tick == 0)
             {
-            #endif
+                _OS_tickInvertBlockedTasksLists();
+            }
+        }
+        #endif
 
-                /* Inside critical section. We can read CurrentTCB directly. */
-                if(     OSstate.CurrentTCB == NULL ||
+        while(  OSstate.BlockedTaskList_NotOverflowed->Length != 0 &&
+                OSstate.BlockedTaskList_NotOverflowed->Head->Value <= OSstate.Tick)
+        {
+            _OS_tickUnblockTask((struct task_t*)OSstate.BlockedTaskList_NotOverflowed->Head->Owner);
+        }
+    }
+    #else
+    {
+        /* No task wakes up before the earliest wakeup. */
+        if(     OSstate.DelayWheelLength != 0 &&
+                OSstate.DelayWheelNext == OSstate.Tick)
+        {
+            /* Only the tasks in the wheel slot of this tick may time out. The
+             other tasks in the slot wake up in a later turn of the wheel. */
+            struct taskHeadList_t* list = DELAY_WHEEL_SLOT(OSstate.Tick);
+            struct taskListNode_t* node = list->Head;
+
+            while(node != (struct taskListNode_t*)list)
+            {
+                struct taskListNode_t* next = node->Next;
+                if(node->Value == OSstate.Tick)
+                {
+                    _OS_tickUnblockTask((struct task_t*)node->Owner);
+                }
+                node = next;
+            }
+
+            _OS_delayWheelUpdateNext();
+        }
+    }
+    #endif
+}
+
+#if (LIBRERTOS_DELAY_WHEEL != 0)
+
+/* Find the earliest wakeup in the delay wheel, after the tick has reached the
+ previous one. Walk the slots in wakeup order and stop at the first task that
+ wakes up in this turn of the wheel. Only the scheduler changes the delay
+ wheel, the interrupts do not need to be disabled. Called by unblock timedout
+ tasks function. */
+static void _OS_delayWheelUpdateNext(void)
+{
+    /* Ticks to the earliest wakeup minus one. A task inserted to wakeup at
+     this same tick wakes up after a whole turn of the tick counter. */
+    tick_t next = MAX_DELAY;
+    tick_t i;
+
+    for(i = 1; i <= LIBRERTOS_DELAY_WHEEL && i <= next; ++i)
+    {
+        struct taskHeadList_t* list = DELAY_WHEEL_SLOT(OSstate.Tick + i);
+        struct taskListNode_t* node;
+
+        for(node = list->Head; node != (struct taskListNode_t*)list; node = node->Next)
+        {
+            tick_t ticksToWakeup = (tick_t)(node->Value - OSstate.Tick - 1U);
+            if(ticksToWakeup < next)
+            {
+                next = ticksToWakeup;
+            }
+        }
+    }
+
+    OSstate.DelayWheelNext = (tick_t)(OSstate.Tick + next + 1U);
+}
+
+#endif /* LIBRERTOS_DELAY_WHEEL */
+
+/* Unblock pending ready tasks. Called by scheduler unlock function. */
+static void _OS_tickUnblockPendingReadyTasks(void)
+{
+    INTERRUPTS_DISABLE();
+    while(OSstate.PendingReadyTaskList.Length != 0)
+    {
+        struct taskListNode_t* node = OSstate.PendingReadyTaskList.Head;
+        struct task_t* task = (struct task_t*)node->Owner;
+
+        /* Remove from pending ready list. The node may be a queue set member
+         node instead of the task event node. */
+        OS_listRemove(node);
+
+        #if (LIBRERTOS_QUEUESET != 0)
+        {
+            /* Stop waiting for the other objects of the queue set. */
+            if(task->PendingSet != NULL)
+            {
+                _OS_taskRemoveSetNodes(task);
+            }
+        }
+        #endif
+
+        #if (LIBRERTOS_PREEMPTION != 0)
+        {
+            #if (LIBRERTOS_PREEMPT_LIMIT > 0)
+            if(task->Priority >= LIBRERTOS_PREEMPT_LIMIT)
+            {
+            #endif
+
+                /* Inside critical section. We can read CurrentTCB directly. */
+                if(     OSstate.CurrentTCB == NULL ||
                         task->Priority > OSstate.CurrentTCB->Priority)
                 {
                     OSstate.HigherReadyTask = 1;
@@ -374,17 +869,65 @@ static void _OS_tickUnblockPendingReadyTasks(void)
         if(task->NodeDelay.List != NULL)
         {
             OS_listRemove(&task->NodeDelay);
+
+            #if (LIBRERTOS_DELAY_WHEEL != 0)
+            {
+                /* The earliest wakeup is kept. If it was this task the OS
+                 wakes up once for nothing. */
+                --OSstate.DelayWheelLength;
+            }
+            #endif
         }
 
         task->State = TASKSTATE_READY;
 
         INTERRUPTS_DISABLE();
 
-        OSstate.Task[task->Priority] = task;
+        #if (LIBRERTOS_TASK_NOTIFY != 0)
+        {
+            /* Stop waiting for a notification (task resumed). */
+            if(task->NotifyState == TASKNOTIFY_WAITING)
+            {
+                task->NotifyState = TASKNOTIFY_NONE;
+            }
+        }
+        #endif
+
+        #if (LIBRERTOS_PRIORITY_INHERITANCE != 0)
+        {
+            /* Stop waiting for the mutex (unlocked or task resumed). */
+            if(task->PendingMutex != NULL)
+            {
+                _OS_taskRemovePendingMutex(task);
+            }
+        }
+        #endif
+
+        _OS_taskSetReady(task);
     }
     INTERRUPTS_ENABLE();
 }
 
+#if (LIBRERTOS_PRIORITY_INHERITANCE != 0)
+
+/* The task stopped pending on a mutex. The owner of the mutex may not need the
+ priority of the task anymore, it must give up the priority before the task is
+ made ready. Must be called with interrupts disabled. Called by unblock
+ functions. */
+static void _OS_taskRemovePendingMutex(struct task_t* task)
+{
+    struct task_t* owner = task->PendingMutex->MutexOwner;
+
+    task->PendingMutex = NULL;
+
+    if(owner != NULL)
+    {
+        OS_taskInheritPriority(owner);
+    }
+}
+
+#endif /* LIBRERTOS_PRIORITY_INHERITANCE */
+
 /** Unlock scheduler (recursive lock). Current task may be preempted if
  scheduler is unlocked. */
 void OS_schedulerUnlock(void)
@@ -400,8 +943,13 @@ void OS_schedulerUnlock(void)
 
             while(OSstate.DelayedTicks != 0)
             {
-                --OSstate.DelayedTicks;
-                ++OSstate.Tick;
+                /* Catch up the delayed ticks jumping straight to the next tick
+                 with work to do. The cost depends on the number of timed-out
+                 tasks, not on the number of delayed ticks. */
+                tick_t ticks = _OS_tickNextWork(OSstate.DelayedTicks);
+
+                OSstate.DelayedTicks = (tick_t)(OSstate.DelayedTicks - ticks);
+                OSstate.Tick = (tick_t)(OSstate.Tick + ticks);
 
                 INTERRUPTS_ENABLE();
                 _OS_tickUnblockTimedoutTasks();
@@ -443,7 +991,11 @@ void OS_schedulerUnlock(void)
     }
 }
 
-/** Create task. */
+/** Create task.
+
+ Only one task can be created in each priority, unless LIBRERTOS_READY_LISTS is
+ enabled. Then tasks with the same priority run in turn (FIFO order).
+ */
 void OS_taskCreate(
         struct task_t* task,
         priority_t priority,
@@ -451,7 +1003,11 @@ void OS_taskCreate(
         taskParameter_t parameter)
 {
     ASSERT(priority < LIBRERTOS_MAX_PRIORITY);
-    ASSERT(OSstate.Task[priority] == NULL);
+    #if (LIBRERTOS_READY_LISTS == 0)
+    {
+        ASSERT(OSstate.Task[priority] == NULL);
+    }
+    #endif
 
     task->State = TASKSTATE_READY;
     task->Function = function;
@@ -461,6 +1017,33 @@ void OS_taskCreate(
     OS_listNodeInit(&task->NodeDelay, task);
     OS_listNodeInit(&task->NodeEvent , task);
 
+    #if (LIBRERTOS_READY_LISTS != 0)
+    {
+        OS_listNodeInit(&task->NodeReady, task);
+    }
+    #endif
+
+    #if (LIBRERTOS_PRIORITY_INHERITANCE != 0)
+    {
+        task->BasePriority = priority;
+        OS_listHeadInit(&task->MutexList);
+        task->PendingMutex = NULL;
+    }
+    #endif
+
+    #if (LIBRERTOS_TASK_NOTIFY != 0)
+    {
+        task->NotifyState = TASKNOTIFY_NONE;
+        task->NotifyValue = 0;
+    }
+    #endif
+
+    #if (LIBRERTOS_QUEUESET != 0)
+    {
+        task->PendingSet = NULL;
+    }
+    #endif
+
     #if (LIBRERTOS_STATISTICS != 0)
     {
         task->TaskRunTime = 0;
@@ -468,7 +1051,147 @@ void OS_taskCreate(
     }
     #endif
 
-    OSstate.Task[priority] = task;
+    _OS_taskSetReady(task);
+}
+
+/* Insert task into the ready table. Must be called with interrupts disabled. */
+static void _OS_taskSetReady(struct task_t*const task)
+{
+    priority_t priority = task->Priority;
+
+    #if (LIBRERTOS_READY_LISTS == 0)
+    {
+        OSstate.Task[priority] = task;
+    }
+    #else
+    {
+        struct taskListNode_t* node = &task->NodeReady;
+        if(node->List != NULL)
+        {
+            /* Already ready. */
+            return;
+        }
+
+        /* Insert at the end of the ready list. */
+        OS_listInsertAfter(&OSstate.ReadyList[priority], OSstate.ReadyList[priority].Tail, node);
+    }
+    #endif
+
+    #if (LIBRERTOS_READY_BITMAP != 0)
+    {
+        OSstate.ReadyBitmap[priority / LIBRERTOS_BITMAP_BITS] |=
+                (readyBitmap_t)1 << (priority % LIBRERTOS_BITMAP_BITS);
+    }
+    #endif
+}
+
+/* Remove task from the ready table. Must be called with interrupts disabled. */
+static void _OS_taskSetNotReady(struct task_t*const task)
+{
+    priority_t priority = task->Priority;
+
+    #if (LIBRERTOS_READY_LISTS == 0)
+    {
+        if(OSstate.Task[priority] != task)
+        {
+            /* Not ready. The slot may be used by a task that inherited its
+             priority. */
+            return;
+        }
+
+        OSstate.Task[priority] = NULL;
+    }
+    #else
+    {
+        struct taskListNode_t* node = &task->NodeReady;
+        if(node->List != NULL)
+        {
+            OS_listRemove(node);
+        }
+
+        if(OSstate.ReadyList[priority].Length != 0)
+        {
+            /* Other tasks with the same priority are still ready. */
+            return;
+        }
+    }
+    #endif
+
+    #if (LIBRERTOS_READY_BITMAP != 0)
+    {
+        OSstate.ReadyBitmap[priority / LIBRERTOS_BITMAP_BITS] &=
+                ~((readyBitmap_t)1 << (priority % LIBRERTOS_BITMAP_BITS));
+    }
+    #endif
+}
+
+#if (LIBRERTOS_PRIORITY_INHERITANCE != 0 || LIBRERTOS_MUTEX_CEILING != 0)
+
+/* Change the priority of a task, moving it in the ready table if it is ready.
+ Used by mutex priority inheritance and priority ceiling. Must be called with
+ interrupts disabled. */
+void OS_taskSetPriority(struct task_t* task, priority_t priority)
+{
+    bool_t ready;
+
+    #if (LIBRERTOS_READY_LISTS == 0)
+    {
+        ready = (OSstate.Task[task->Priority] == task);
+    }
+    #else
+    {
+        ready = (task->NodeReady.List != NULL);
+    }
+    #endif
+
+    if(ready != 0)
+    {
+        _OS_taskSetNotReady(task);
+
+        #if (LIBRERTOS_READY_LISTS == 0)
+        {
+            /* With one task per priority the new priority must be free. */
+            ASSERT(OSstate.Task[priority] == NULL);
+        }
+        #endif
+    }
+
+    #if (LIBRERTOS_PREEMPTION != 0)
+    {
+        if(priority < task->Priority && task == OSstate.CurrentTCB)
+        {
+            /* Lowering the priority of the current task. A task with a
+             priority in between may be ready. */
+            OSstate.HigherReadyTask = 1;
+            OSstate.SchedulerUnlockTodo = 1;
+        }
+    }
+    #endif /* LIBRERTOS_PREEMPTION */
+
+    task->Priority = priority;
+
+    if(ready != 0)
+    {
+        _OS_taskSetReady(task);
+    }
+}
+
+#endif /* LIBRERTOS_PRIORITY_INHERITANCE || LIBRERTOS_MUTEX_CEILING */
+
+/* Get the ready task to be scheduled in a priority, NULL if there is none. Must
+ be called with interrupts disabled. */
+static struct task_t* _OS_taskGetReady(priority_t priority)
+{
+    #if (LIBRERTOS_READY_LISTS == 0)
+    {
+        return OSstate.Task[priority];
+    }
+    #else
+    {
+        struct taskHeadList_t* list = &OSstate.ReadyList[priority];
+        return (list->Length != 0 ? (struct task_t*)list->Head->Owner : NULL);
+    }
+    #endif
 }
 
 /** Return current task priority. */
@@ -493,32 +1216,128 @@ void OS_taskDelay(tick_t ticksToDelay)
     if(ticksToDelay != 0)
     {
         tick_t tickNow = (tick_t)(OSstate.Tick + OSstate.DelayedTicks);
-        tick_t tickToWakeup = (tick_t)(tickNow + ticksToDelay);
+        _OS_taskDelayUntilTick(tickNow, (tick_t)(tickNow + ticksToDelay));
+    }
+    OS_schedulerUnlock();
+}
 
-        struct task_t* task = OS_getCurrentTask();
-        struct taskListNode_t* taskBlockedNode = &task->NodeDelay;
-        struct taskHeadList_t* blockedTaskList;
+/** Delay task until a period after its last wakeup.
+
+ Unlike OS_taskDelay(), the wakeup tick does not depend on when the task is
+ called, so a periodic task does not drift by its own execution time.
+
+ If the wakeup tick has already passed (deadline overrun) the task is not
+ delayed and the missed periods are skipped, *lastWake is set to the last of
+ them.
 
-        if(tickToWakeup > tickNow)
+ @param lastWake Tick of the last wakeup. Must be initialized with
+ OS_getTickCount(), and is updated by the function.
+ @param period Period of the task in ticks.
+ @return 1 if the deadline was overrun, 0 otherwise.
+
+ Run task every 10 ticks (lastWake = OS_getTickCount() before the first run):
+ static tick_t lastWake;
+ do_something();
+ OS_taskDelayUntil(&lastWake, 10);
+ */
+bool_t OS_taskDelayUntil(tick_t* lastWake, tick_t period)
+{
+    bool_t overrun;
+
+    ASSERT(period != 0);
+
+    OS_schedulerLock();
+    {
+        tick_t tickNow = (tick_t)(OSstate.Tick + OSstate.DelayedTicks);
+        tick_t elapsed = (tick_t)(tickNow - *lastWake);
+
+        if(elapsed >= period)
         {
-            /* Not overflowed. */
-            blockedTaskList = OSstate.BlockedTaskList_NotOverflowed;
+            /* Deadline overrun. Skip the missed periods, do not delay. */
+            *lastWake = (tick_t)(*lastWake + (tick_t)(elapsed - elapsed % period));
+            overrun = 1;
         }
         else
         {
-            /* Overflowed. */
-            blockedTaskList = OSstate.BlockedTaskList_Overflowed;
+            *lastWake = (tick_t)(*lastWake + period);
+            _OS_taskDelayUntilTick(tickNow, *lastWake);
+            overrun = 0;
         }
+    }
+    OS_schedulerUnlock();
 
-        INTERRUPTS_DISABLE();
-        task->State = TASKSTATE_BLOCKED;
-        OSstate.Task[task->Priority] = NULL;
-        INTERRUPTS_ENABLE();
+    return overrun;
+}
 
-        /* Insert task on list. */
-        OS_listInsert(blockedTaskList, taskBlockedNode, tickToWakeup);
+/* Block the current task until tick tickToWakeup, tickNow being the tick
+ counter plus the delayed ticks. Must be called with interrupts enabled and
+ scheduler locked. */
+static void _OS_taskDelayUntilTick(tick_t tickNow, tick_t tickToWakeup)
+{
+    struct task_t* task = OS_getCurrentTask();
+
+    #if (LIBRERTOS_MONOTONIC_TICK != 0)
+    {
+        if(tickToWakeup < tickNow)
+        {
+            /* MAX_DELAY. The tick never reaches the wakeup tick. */
+            tickToWakeup = MAX_DELAY;
+        }
     }
-    OS_schedulerUnlock();
+    #else
+    {
+        (void)tickNow;
+    }
+    #endif
+
+    INTERRUPTS_DISABLE();
+    task->State = TASKSTATE_BLOCKED;
+    _OS_taskSetNotReady(task);
+    INTERRUPTS_ENABLE();
+
+    /* Insert task on list. */
+    _OS_taskDelayInsert(&task->NodeDelay, tickToWakeup);
+}
+
+/* Insert task delay node into the blocked tasks lists, to wakeup at tick
+ tickToWakeup. Must be called with interrupts enabled and scheduler locked. */
+static void _OS_taskDelayInsert(struct taskListNode_t* node, tick_t tickToWakeup)
+{
+    #if (LIBRERTOS_DELAY_WHEEL == 0)
+    {
+        struct taskHeadList_t* blockedTaskList = OSstate.BlockedTaskList_NotOverflowed;
+
+        #if (LIBRERTOS_MONOTONIC_TICK == 0)
+        {
+            if(tickToWakeup <= OSstate.Tick)
+            {
+                /* Overflowed. Compare with OSstate.Tick, not with the tick
+                 plus delayed ticks, since those may overflow the tick
+                 counter. */
+                blockedTaskList = OSstate.BlockedTaskList_Overflowed;
+            }
+        }
+        #endif
+
+        OS_listInsert(blockedTaskList, node, tickToWakeup);
+    }
+    #else
+    {
+        /* Constant time. The wheel slots are not ordered. */
+        struct taskHeadList_t* list = DELAY_WHEEL_SLOT(tickToWakeup);
+        node->Value = tickToWakeup;
+        OS_listInsertAfter(list, list->Tail, node);
+
+        /* Keep the earliest wakeup. */
+        if(     OSstate.DelayWheelLength == 0 ||
+                (tick_t)(tickToWakeup - OSstate.Tick - 1U) <
+                (tick_t)(OSstate.DelayWheelNext - OSstate.Tick - 1U))
+        {
+            OSstate.DelayWheelNext = tickToWakeup;
+        }
+        ++OSstate.DelayWheelLength;
+    }
+    #endif
 }
 
 /** Resume task. */
@@ -537,6 +1356,17 @@ void OS_taskResume(struct task_t* task)
                 OS_listRemove(&task->NodeEvent);
             }
 
+            #if (LIBRERTOS_TASK_NOTIFY != 0)
+            {
+                /* Stop waiting for a notification. A later notification must
+                 not make the task ready while it pends on something else. */
+                if(task->NotifyState == TASKNOTIFY_WAITING)
+                {
+                    task->NotifyState = TASKNOTIFY_NONE;
+                }
+            }
+            #endif
+
             /* Add to pending ready tasks list. */
             OS_listInsertAfter(&OSstate.PendingReadyTaskList, OSstate.PendingReadyTaskList.Head, node);
 
@@ -548,6 +1378,216 @@ void OS_taskResume(struct task_t* task)
     OS_schedulerUnlock();
 }
 
+#if (LIBRERTOS_TASK_NOTIFY != 0)
+
+/** Notify task.
+
+ Update the notification value of the task. If the task is waiting for a
+ notification it is made ready without going through an event list. Can be
+ called by tasks and interrupts.
+
+ @param value Value used by the action (ignored by TASKNOTIFY_INCREMENT).
+ @param action How to update the notification value.
+
+ Set bit 0 of the task notification value:
+ OS_taskNotify(&task, 0x01, TASKNOTIFY_SETBITS)
+
+ Increment the task notification value (counting semaphore):
+ OS_taskNotify(&task, 0, TASKNOTIFY_INCREMENT)
+ */
+void OS_taskNotify(
+        struct task_t* task,
+        notifyValue_t value,
+        enum taskNotifyAction_t action)
+{
+    CRITICAL_VAL();
+
+    OS_schedulerLock();
+    CRITICAL_ENTER();
+    {
+        switch(action)
+        {
+        case TASKNOTIFY_SETBITS:
+            task->NotifyValue = (notifyValue_t)(task->NotifyValue | value);
+            break;
+        case TASKNOTIFY_INCREMENT:
+            task->NotifyValue = (notifyValue_t)(task->NotifyValue + 1);
+            break;
+        default:
+            task->NotifyValue = value;
+            break;
+        }
+
+        if(     task->NotifyState == TASKNOTIFY_WAITING &&
+                task->NodeEvent.List == NULL)
+        {
+            /* Waiting only for the notification, not in any event list or
+             already in the pending ready list. */
+            if(task->State == TASKSTATE_SUSPENDED)
+            {
+                /* Not in any list. Ready straight away. */
+                task->State = TASKSTATE_READY;
+                _OS_taskSetReady(task);
+
+                #if (LIBRERTOS_PREEMPTION != 0)
+                {
+                    #if (LIBRERTOS_PREEMPT_LIMIT > 0)
+                    if(task->Priority >= LIBRERTOS_PREEMPT_LIMIT)
+                    {
+                    #endif
+
+                        /* Inside critical section. We can read CurrentTCB
+                         directly. */
+                        if(     OSstate.CurrentTCB == NULL ||
+                                task->Priority > OSstate.CurrentTCB->Priority)
+                        {
+                            OSstate.HigherReadyTask = 1;
+                            OSstate.SchedulerUnlockTodo = 1;
+                        }
+
+                    #if (LIBRERTOS_PREEMPT_LIMIT > 0)
+                    }
+                    #endif
+                }
+                #endif /* LIBRERTOS_PREEMPTION */
+            }
+            else
+            {
+                /* Blocked with timeout. The delay list is changed only with
+                 interrupts enabled, so let scheduler unlock do it. */
+                OS_listInsertAfter(&OSstate.PendingReadyTaskList, OSstate.PendingReadyTaskList.Head, &task->NodeEvent);
+
+                /* Scheduler unlock has work todo. */
+                OSstate.SchedulerUnlockTodo = 1;
+            }
+        }
+
+        task->NotifyState = TASKNOTIFY_RECEIVED;
+    }
+    CRITICAL_EXIT();
+    OS_schedulerUnlock();
+}
+
+/** Take notification.
+
+ Can be called only by tasks.
+
+ Succeed if the current task has received a notification. Return its
+ notification value and clear it.
+
+ @param value Pointer to store the notification value (may be NULL).
+ @return 1 if success, 0 otherwise.
+
+ Take notification:
+ OS_taskNotifyTake(&value)
+ */
+bool_t OS_taskNotifyTake(notifyValue_t* value)
+{
+    bool_t val;
+    CRITICAL_VAL();
+
+    CRITICAL_ENTER();
+    {
+        /* Inside critical section. We can read CurrentTCB directly. */
+        struct task_t* task = OSstate.CurrentTCB;
+
+        val = (task->NotifyState == TASKNOTIFY_RECEIVED);
+        if(val != 0)
+        {
+            if(value != NULL)
+            {
+                *value = task->NotifyValue;
+            }
+
+            task->NotifyValue = 0;
+            task->NotifyState = TASKNOTIFY_NONE;
+        }
+    }
+    CRITICAL_EXIT();
+
+    return val;
+}
+
+/** Take or pend on notification.
+
+ Try take notification; pend on it if not successful.
+
+ Can be called only by tasks.
+
+ The task will not run until it is notified or the timeout expires.
+
+ @param value Pointer to store the notification value (may be NULL).
+ @param ticksToWait Number of ticks the task will wait for the notification
+ (timeout). Passing MAX_DELAY the task will not wakeup by timeout.
+ @return 1 if success, 0 otherwise.
+
+ Take or pend on notification without timeout:
+ OS_taskNotifyTakePend(&value, MAX_DELAY)
+
+ Take or pend on notification with timeout of 10 ticks:
+ OS_taskNotifyTakePend(&value, 10)
+ */
+bool_t OS_taskNotifyTakePend(notifyValue_t* value, tick_t ticksToWait)
+{
+    bool_t val = OS_taskNotifyTake(value);
+    if(val == 0)
+    {
+        OS_taskNotifyPend(ticksToWait);
+    }
+    return val;
+}
+
+/** Pend on notification.
+
+ Can be called only by tasks.
+
+ The task will not run until it is notified or the timeout expires.
+
+ @param ticksToWait Number of ticks the task will wait for the notification
+ (timeout). Passing MAX_DELAY the task will not wakeup by timeout.
+
+ Pend on notification without timeout:
+ OS_taskNotifyPend(MAX_DELAY)
+
+ Pend on notification with timeout of 10 ticks:
+ OS_taskNotifyPend(10)
+ */
+void OS_taskNotifyPend(tick_t ticksToWait)
+{
+    if(ticksToWait != 0U)
+    {
+        struct task_t* task = OS_getCurrentTask();
+
+        OS_schedulerLock();
+        INTERRUPTS_DISABLE();
+        if(task->NotifyState != TASKNOTIFY_RECEIVED)
+        {
+            task->NotifyState = TASKNOTIFY_WAITING;
+
+            /* Suspend if ticks to wait is maximum delay, block with timeout
+             otherwise. */
+            if(ticksToWait == MAX_DELAY)
+            {
+                task->State = TASKSTATE_SUSPENDED;
+                _OS_taskSetNotReady(task);
+                INTERRUPTS_ENABLE();
+            }
+            else
+            {
+                INTERRUPTS_ENABLE();
+                OS_taskDelay(ticksToWait);
+            }
+        }
+        else
+        {
+            INTERRUPTS_ENABLE();
+        }
+        OS_schedulerUnlock();
+    }
+}
+
+#endif /* LIBRERTOS_TASK_NOTIFY */
+
 /** Get current OS tick. */
 tick_t OS_getTickCount(void)
 {
@@ -733,113 +1773,121 @@ void OS_eventPrePendTask(
     OS_listInsertAfter(list, (struct taskListNode_t*)list, node);
 }
 
-/* Pend task on an event (part 2). Must be called with interrupts enabled and
- scheduler locked. Parameter ticksToWait must not be zero. */
-void OS_eventPendTask(
+/* Move a node pre-pended on the head of an event list to its position, ordered
+ by priority. Must be called with interrupts disabled and scheduler locked.
+ Interrupts are enabled while the list is walked, and disabled again on return.
+ The node is not in the list anymore if an interrupt unblocked its task. */
+void OS_eventPendNode(
         struct taskHeadList_t* list,
-        struct task_t* task,
-        tick_t ticksToWait)
+        struct taskListNode_t* node,
+        priority_t priority)
 {
-    struct taskListNode_t* node = &task->NodeEvent;
-    priority_t priority = task->Priority;
-
-    INTERRUPTS_DISABLE();
-
-    /* Find correct position for the task in the event list. This list may
+    /* Find correct position for the node in the event list. This list may
      be changed by interrupts, so we must do things carefully. */
+    struct taskListNode_t* pos;
+
+    for(;;)
     {
-        struct taskListNode_t* pos;
+        pos = list->Tail;
 
-        for(;;)
+        while(pos != LIST_HEAD(list))
         {
-            pos = list->Tail;
-
-            while(pos != LIST_HEAD(list))
-            {
-                INTERRUPTS_ENABLE();
+            INTERRUPTS_ENABLE();
 
-                /* For test coverage only. This macro is used as a deterministic
-                 way to create a concurrent access. */
-                LIBRERTOS_TEST_CONCURRENT_ACCESS();
-
-                if(((struct task_t*)pos->Owner)->Priority <= priority)
-                {
-                    /* Found where to insert. Break while(). */
-                    INTERRUPTS_DISABLE();
-                    break;
-                }
+            /* For test coverage only. This macro is used as a deterministic
+             way to create a concurrent access. */
+            LIBRERTOS_TEST_CONCURRENT_ACCESS();
 
+            if(((struct task_t*)pos->Owner)->Priority <= priority)
+            {
+                /* Found where to insert. Break while(). */
                 INTERRUPTS_DISABLE();
-                if(pos->List != list)
-                {
-                    /* This position was removed from the list. An interrupt
-                     resumed this task. Break while(). */
-                    break;
-                }
-
-                /* As this task is inserted in the head of the list, if an
-                 interrupt resumed the task then pos also must have been
-                 modified.
-                 So break the while loop if current task was changed is
-                 redundant. */
-
-                pos = pos->Previous;
+                break;
             }
 
-            if(     pos != LIST_HEAD(list) &&
-                    pos->List != list &&
-                    node->List == list)
-            {
-                /* This pos was removed from the list and node was not
-                 removed. Must restart to find where to insert node.
-                 Continue for(;;). */
-                continue;
-            }
-            else
+            INTERRUPTS_DISABLE();
+            if(pos->List != list)
             {
-                /* Found where to insert. Insert after pos.
-                 OR
-                 Item node was removed from the list (interrupt resumed the
-                 task). Nothing to insert.
-                 Break for(;;). */
+                /* This position was removed from the list. An interrupt
+                 resumed this task. Break while(). */
                 break;
             }
+
+            /* As this node is inserted in the head of the list, if an
+             interrupt resumed the task then pos also must have been
+             modified.
+             So break the while loop if current task was changed is
+             redundant. */
+
+            pos = pos->Previous;
         }
 
-        if(node->List == list)
+        if(     pos != LIST_HEAD(list) &&
+                pos->List != list &&
+                node->List == list)
         {
-            /* If an interrupt didn't resume the task. */
+            /* This pos was removed from the list and node was not
+             removed. Must restart to find where to insert node.
+             Continue for(;;). */
+            continue;
+        }
+        else
+        {
+            /* Found where to insert. Insert after pos.
+             OR
+             Item node was removed from the list (interrupt resumed the
+             task). Nothing to insert.
+             Break for(;;). */
+            break;
+        }
+    }
 
-            /* Don't need to remove and insert if the task is already in its
-             position. */
+    /* Don't need to remove and insert if the node is already in its
+     position, or if an interrupt resumed the task. */
+    if(node->List == list && node != pos)
+    {
+        /* Now insert in the right position. */
+        OS_listRemove(node);
+        OS_listInsertAfter(list, pos, node);
+    }
+}
 
-            if(node != pos)
-            {
-                /* Now insert in the right position. */
-                OS_listRemove(node);
-                OS_listInsertAfter(list, pos, node);
-            }
+/* Pend task on an event (part 2). Must be called with interrupts enabled and
+ scheduler locked. Parameter ticksToWait must not be zero. */
+void OS_eventPendTask(
+        struct taskHeadList_t* list,
+        struct task_t* task,
+        tick_t ticksToWait)
+{
+    struct taskListNode_t* node = &task->NodeEvent;
 
-            /* Suspend or block task. */
-            /* Ticks enabled. Suspend if ticks to wait is maximum delay, block with
-                timeout otherwise. */
-            if(ticksToWait == MAX_DELAY)
-            {
-                task->State = TASKSTATE_SUSPENDED;
-                OSstate.Task[task->Priority] = NULL;
-                INTERRUPTS_ENABLE();
-            }
-            else
-            {
-                INTERRUPTS_ENABLE();
-                OS_taskDelay(ticksToWait);
-            }
+    INTERRUPTS_DISABLE();
+
+    OS_eventPendNode(list, node, task->Priority);
+
+    if(node->List == list)
+    {
+        /* If an interrupt didn't resume the task. */
+
+        /* Suspend or block task. */
+        /* Ticks enabled. Suspend if ticks to wait is maximum delay, block with
+            timeout otherwise. */
+        if(ticksToWait == MAX_DELAY)
+        {
+            task->State = TASKSTATE_SUSPENDED;
+            _OS_taskSetNotReady(task);
+            INTERRUPTS_ENABLE();
         }
         else
         {
             INTERRUPTS_ENABLE();
+            OS_taskDelay(ticksToWait);
         }
     }
+    else
+    {
+        INTERRUPTS_ENABLE();
+    }
 }
 
 /* Unblock task in an event list. Must be called with scheduler locked and in a
@@ -847,16 +1895,95 @@ void OS_eventPendTask(
 void OS_eventUnblockTasks(struct taskHeadList_t* list)
 {
     if(list->Length != 0)
+    {
+        OS_eventUnblockNode(list->Tail);
+    }
+}
+
+/* Unblock the task of an event node, anywhere in its event list. Must be called
+ with scheduler locked and in a critical section. */
+void OS_eventUnblockNode(struct taskListNode_t* node)
+{
+    /* Remove from event list. */
+    OS_listRemove(node);
+
+    /* Insert in the pending ready tasks . */
+    OS_listInsertAfter(&OSstate.PendingReadyTaskList, OSstate.PendingReadyTaskList.Head, node);
+
+    /* Scheduler unlock has work todo. */
+    OSstate.SchedulerUnlockTodo = 1;
+}
+
+/* Unblock up to num tasks in an event list, higher priority first. Must be
+ called with scheduler locked and in a critical section. */
+void OS_eventUnblockTasksNum(struct taskHeadList_t* list, len_t num)
+{
+    while(num != 0 && list->Length != 0)
+    {
+        OS_eventUnblockNode(list->Tail);
+        --num;
+    }
+}
+
+/* Unblock tasks in an event list, higher priority first, while the lengths
+ they wait for (event node value) fit in the budget. Stop at the first task
+ that does not fit, so lower priority tasks do not overtake it. Must be called
+ with scheduler locked and in a critical section. */
+void OS_eventUnblockTasksBudget(struct taskHeadList_t* list, len_t budget)
+{
+    while(list->Length != 0)
     {
         struct taskListNode_t* node = list->Tail;
+        len_t length = (len_t)node->Value; /* Length waiting for. */
 
-        /* Remove from event list. */
-        OS_listRemove(node);
+        if(length > budget)
+        {
+            break;
+        }
+
+        budget = (len_t)(budget - length);
+        OS_eventUnblockNode(node);
+    }
+}
+
+#if (LIBRERTOS_QUEUESET != 0)
+
+/* Suspend the task if ticksToWait is MAX_DELAY, block it with timeout
+ otherwise. Used to pend on a queue set, after its member nodes were inserted
+ in the event lists. Must be called with interrupts disabled and scheduler
+ locked. Enables interrupts. */
+void OS_eventBlockTask(struct task_t* task, tick_t ticksToWait)
+{
+    if(ticksToWait == MAX_DELAY)
+    {
+        task->State = TASKSTATE_SUSPENDED;
+        _OS_taskSetNotReady(task);
+        INTERRUPTS_ENABLE();
+    }
+    else
+    {
+        INTERRUPTS_ENABLE();
+        OS_taskDelay(ticksToWait);
+    }
+}
 
-        /* Insert in the pending ready tasks . */
-        OS_listInsertAfter(&OSstate.PendingReadyTaskList, OSstate.PendingReadyTaskList.Head, node);
+/* Remove the queue set member nodes of a task from the event lists (or from
+ the pending ready list). Must be called with interrupts disabled. */
+static void _OS_taskRemoveSetNodes(struct task_t* task)
+{
+    struct QueueSet_t* set = task->PendingSet;
+    len_t i;
 
-        /* Scheduler unlock has work todo. */
-        OSstate.SchedulerUnlockTodo = 1;
+    for(i = 0; i < set->Num; ++i)
+    {
+        struct taskListNode_t* node = &set->Members[i].NodeEvent;
+        if(node->List != NULL)
+        {
+            OS_listRemove(node);
+        }
     }
+
+    task->PendingSet = NULL;
 }
+
+#endif /* LIBRERTOS_QUEUESET */
@@ -58,10 +58,91 @@ extern "C" {
 #define LIBRERTOS_STATISTICS         0  /* boolean */
 #endif
 
+#ifndef LIBRERTOS_READY_BITMAP
+#define LIBRERTOS_READY_BITMAP       0  /* boolean */
+#endif
+
+#ifndef LIBRERTOS_READY_LISTS
+#define LIBRERTOS_READY_LISTS        0  /* boolean */
+#endif
+
+#ifndef LIBRERTOS_DELAY_WHEEL
+#define LIBRERTOS_DELAY_WHEEL        0  /* integer >= 0, power of two (0 disables) */
+#endif
+
+#if ((LIBRERTOS_DELAY_WHEEL & (LIBRERTOS_DELAY_WHEEL - 1)) != 0)
+#error "LIBRERTOS_DELAY_WHEEL is not a power of two!"
+#endif
+
+#ifndef LIBRERTOS_TIMER_WHEEL
+#define LIBRERTOS_TIMER_WHEEL        0  /* integer >= 0, power of two (0 disables) */
+#endif
+
+#if ((LIBRERTOS_TIMER_WHEEL & (LIBRERTOS_TIMER_WHEEL - 1)) != 0)
+#error "LIBRERTOS_TIMER_WHEEL is not a power of two!"
+#endif
+
+#ifndef LIBRERTOS_MONOTONIC_TICK
+#define LIBRERTOS_MONOTONIC_TICK     0  /* boolean */
+#endif
+
+/* A monotonic tick must never overflow, tick_t must have 64 bits. */
+typedef char librertos_monotonic_tick_check[
+        (LIBRERTOS_MONOTONIC_TICK == 0 || sizeof(tick_t) >= 8) ? 1 : -1];
+
+#ifndef LIBRERTOS_PRIORITY_INHERITANCE
+#define LIBRERTOS_PRIORITY_INHERITANCE 0 /* boolean */
+#endif
+
+#ifndef LIBRERTOS_MUTEX_CEILING
+#define LIBRERTOS_MUTEX_CEILING      0  /* boolean */
+#endif
+
+#ifndef LIBRERTOS_TASK_NOTIFY
+#define LIBRERTOS_TASK_NOTIFY        0  /* boolean */
+#endif
+
+#ifndef LIBRERTOS_FIFO_POW2
+#define LIBRERTOS_FIFO_POW2          0  /* boolean */
+#endif
+
+#ifndef LIBRERTOS_FIFO_SPSC
+#define LIBRERTOS_FIFO_SPSC          0  /* boolean */
+#endif
+
+#ifndef LIBRERTOS_QUEUESET
+#define LIBRERTOS_QUEUESET           0  /* boolean */
+#endif
+
+#ifndef LIBRERTOS_QUEUE_SMALL_ITEMS
+#define LIBRERTOS_QUEUE_SMALL_ITEMS  0  /* boolean */
+#endif
+
+#if (LIBRERTOS_FIFO_SPSC != 0 && LIBRERTOS_FIFO_POW2 == 0)
+#error "LIBRERTOS_FIFO_SPSC requires LIBRERTOS_FIFO_POW2!"
+#endif
+
+#ifndef MEMORY_BARRIER
+#if (LIBRERTOS_FIFO_SPSC != 0)
+#error "LIBRERTOS_FIFO_SPSC requires MEMORY_BARRIER() in projdefs.h!"
+#endif
+#define MEMORY_BARRIER()
+#endif
+
 #ifndef LIBRERTOS_TEST_CONCURRENT_ACCESS
 #define LIBRERTOS_TEST_CONCURRENT_ACCESS()
 #endif
 
+#if (LIBRERTOS_READY_BITMAP != 0)
+
+/* Ready bitmap. One bit per priority, set if the priority has a ready task. */
+typedef uint32_t readyBitmap_t;
+
+#define LIBRERTOS_BITMAP_BITS        32
+#define LIBRERTOS_BITMAP_WORDS       ((LIBRERTOS_MAX_PRIORITY + LIBRERTOS_BITMAP_BITS - 1) / LIBRERTOS_BITMAP_BITS)
+
+#endif
+
 typedef void* taskParameter_t;
 typedef void(*taskFunction_t)(taskParameter_t);
 
@@ -71,7 +152,7 @@ struct taskListNode_t;
 struct taskHeadList_t {
     struct taskListNode_t* Head;
     struct taskListNode_t* Tail;
-    uint8_t                Length;
+    listlen_t              Length;
 };
 
 struct taskListNode_t {
@@ -89,6 +170,32 @@ enum taskState_t {
     TASKSTATE_NOTINITIALIZED
 };
 
+#if (LIBRERTOS_TASK_NOTIFY != 0)
+
+typedef len_t notifyValue_t;
+
+enum taskNotifyState_t {
+    TASKNOTIFY_NONE = 0, /* No notification. */
+    TASKNOTIFY_WAITING, /* Task waiting for a notification. */
+    TASKNOTIFY_RECEIVED /* Notification not taken yet. */
+};
+
+enum taskNotifyAction_t {
+    TASKNOTIFY_SETBITS = 0, /* Or the value into the notification value. */
+    TASKNOTIFY_INCREMENT, /* Increment the notification value. */
+    TASKNOTIFY_OVERWRITE /* Overwrite the notification value. */
+};
+
+#endif
+
+#if (LIBRERTOS_QUEUESET != 0)
+struct QueueSet_t;
+#endif
+
+#if (LIBRERTOS_PRIORITY_INHERITANCE != 0)
+struct Mutex_t;
+#endif
+
 struct task_t {
     enum taskState_t      State;
     taskFunction_t        Function;
@@ -97,6 +204,25 @@ struct task_t {
     struct taskListNode_t NodeDelay;
     struct taskListNode_t NodeEvent;
 
+    #if (LIBRERTOS_READY_LISTS != 0)
+        struct taskListNode_t NodeReady;
+    #endif
+
+    #if (LIBRERTOS_PRIORITY_INHERITANCE != 0)
+        priority_t        BasePriority; /* Priority given on task creation. */
+        struct taskHeadList_t MutexList; /* Mutexes locked by the task. */
+        struct Mutex_t*   PendingMutex; /* Mutex the task is pending on. */
+    #endif
+
+    #if (LIBRERTOS_TASK_NOTIFY != 0)
+        volatile enum taskNotifyState_t NotifyState;
+        notifyValue_t     NotifyValue;
+    #endif
+
+    #if (LIBRERTOS_QUEUESET != 0)
+        struct QueueSet_t* PendingSet; /* Queue set the task is pending on. */
+    #endif
+
     #if (LIBRERTOS_STATISTICS != 0)
         stattime_t        TaskRunTime;
         stattime_t        TaskNumSchedules;
@@ -115,7 +241,8 @@ typedef void(*timerFunction_t)(struct Timer_t*, timerParameter_t);
 enum timerType_t {
     TIMERTYPE_ONESHOT  = 0x00, /* Timer need to be reset to run. Run after period has passed. */
     TIMERTYPE_AUTO     = 0x01, /* Auto reset timer after it has run. */
-    TIMERTYPE_NOPERIOD = 0x02 /* Timer need to be reset to run. Run as soon as it is reset. */
+    TIMERTYPE_NOPERIOD = 0x02, /* Timer need to be reset to run. Run as soon as it is reset. */
+    TIMERTYPE_PERIODIC = 0x03 /* Auto reset timer after it has run, a period after its last expiry (no drift). */
 };
 
 struct Timer_t {
@@ -124,6 +251,7 @@ struct Timer_t {
     timerFunction_t       Function;
     timerParameter_t      Parameter;
     struct taskListNode_t NodeTimer;
+    len_t                 Overruns; /* Periods missed by a periodic timer. */
 };
 
 #endif
@@ -141,23 +269,53 @@ struct libreRtosState_t {
         volatile bool_t        HigherReadyTask; /* Higher priority task is ready to run. */
     #endif
 
-    struct task_t*             Task[LIBRERTOS_MAX_PRIORITY]; /* Task priorities. */
+    #if (LIBRERTOS_READY_LISTS == 0)
+        struct task_t*         Task[LIBRERTOS_MAX_PRIORITY]; /* Task priorities. */
+    #else
+        struct taskHeadList_t  ReadyList[LIBRERTOS_MAX_PRIORITY]; /* Ready tasks of each priority (FIFO). */
+    #endif
+
+    #if (LIBRERTOS_READY_BITMAP != 0)
+        readyBitmap_t          ReadyBitmap[LIBRERTOS_BITMAP_WORDS]; /* Priorities with a ready task. */
+    #endif
 
     tick_t                     Tick; /* OS tick. */
     tick_t                     DelayedTicks; /* OS delayed tick (scheduler was locked). */
-    struct taskHeadList_t*     BlockedTaskList_NotOverflowed; /* List with blocked tasks (not overflowed). */
-    struct taskHeadList_t*     BlockedTaskList_Overflowed; /* List with blocked tasks (overflowed). */
+
+    #if (LIBRERTOS_DELAY_WHEEL == 0)
+        struct taskHeadList_t* BlockedTaskList_NotOverflowed; /* List with blocked tasks (not overflowed). */
+    #endif
+    #if (LIBRERTOS_DELAY_WHEEL == 0 && LIBRERTOS_MONOTONIC_TICK == 0)
+        struct taskHeadList_t* BlockedTaskList_Overflowed; /* List with blocked tasks (overflowed). */
+    #endif
 
     struct taskHeadList_t      PendingReadyTaskList; /* List with ready tasks not removed from list of blocked tasks. */
-    struct taskHeadList_t      BlockedTaskList1; /* List with blocked tasks number 1. */
-    struct taskHeadList_t      BlockedTaskList2; /* List with blocked tasks number 2. */
+
+    #if (LIBRERTOS_DELAY_WHEEL == 0)
+        struct taskHeadList_t  BlockedTaskList1; /* List with blocked tasks number 1. */
+        #if (LIBRERTOS_MONOTONIC_TICK == 0)
+            struct taskHeadList_t BlockedTaskList2; /* List with blocked tasks number 2. */
+        #endif
+    #else
+        struct taskHeadList_t  DelayWheel[LIBRERTOS_DELAY_WHEEL]; /* Blocked tasks hashed by wakeup tick. */
+        listlen_t              DelayWheelLength; /* Number of blocked tasks in the delay wheel. */
+        tick_t                 DelayWheelNext; /* Earliest wakeup tick in the delay wheel (or earlier, if that task was removed). */
+    #endif
 
     #if (LIBRERTOS_SOFTWARETIMERS != 0)
         tick_t                 TaskTimerLastRun;
         struct task_t          TaskTimerTCB; /* Task control block of timer task. */
-        struct taskListNode_t* TimerIndex; /* Points to next timer to be run in TimerList. */
-        struct taskHeadList_t  TimerList; /* List of running timers ordered by wakeup time. */
-        struct taskHeadList_t  TimerUnorderedList; /* List of running timers to be ordered by wakeup time. */
+        #if (LIBRERTOS_TIMER_WHEEL == 0)
+            struct taskListNode_t* TimerIndex; /* Points to next timer to be run in TimerList. */
+            struct taskHeadList_t  TimerList; /* List of running timers ordered by wakeup time. */
+            struct taskHeadList_t  TimerUnorderedList; /* List of running timers to be ordered by wakeup time. */
+        #else
+            struct taskHeadList_t  TimerWheel[LIBRERTOS_TIMER_WHEEL]; /* Running timers hashed by wakeup time. */
+            listlen_t              TimerWheelLength; /* Number of timers in the wheel. */
+            tick_t                 TimerWheelNext; /* Earliest wakeup time in the wheel (or earlier, if that timer was removed). */
+            struct taskHeadList_t  TimerUnorderedList; /* List of running timers to be inserted into the wheel. */
+            struct taskHeadList_t  TimerExpiredList; /* List of expired timers to be run. */
+        #endif
     #endif
 
     #if (LIBRERTOS_STATISTICS != 0)
@@ -177,6 +335,8 @@ extern struct libreRtosState_t OSstate;
 void OS_init(void);
 void OS_start(void);
 void OS_tick(void);
+void OS_tickAdvance(tick_t ticks);
+tick_t OS_getTicksToWakeup(void);
 void OS_scheduler(void);
 
 void OS_schedulerLock(void);
@@ -189,11 +349,24 @@ void OS_taskCreate(
         taskParameter_t parameter);
 
 void OS_taskDelay(tick_t ticksToDelay);
+bool_t OS_taskDelayUntil(tick_t* lastWake, tick_t period);
 void OS_taskResume(struct task_t* task);
 
 struct task_t* OS_getCurrentTask(void);
 tick_t OS_getTickCount(void);
 
+#if (LIBRERTOS_TASK_NOTIFY != 0)
+
+void OS_taskNotify(
+        struct task_t* task,
+        notifyValue_t value,
+        enum taskNotifyAction_t action);
+bool_t OS_taskNotifyTake(notifyValue_t* value);
+bool_t OS_taskNotifyTakePend(notifyValue_t* value, tick_t ticksToWait);
+void OS_taskNotifyPend(tick_t ticksToWait);
+
+#endif
+
 #if (LIBRERTOS_SOFTWARETIMERS != 0)
 
 void OS_timerTaskCreate(priority_t priority);
@@ -210,6 +383,7 @@ void Timer_reset(struct Timer_t* timer);
 void Timer_stop(struct Timer_t* timer);
 
 bool_t Timer_isRunning(const struct Timer_t* timer);
+len_t Timer_getOverruns(const struct Timer_t* timer);
 
 #endif
 
@@ -265,10 +439,23 @@ struct Mutex_t {
     len_t           Count;
     struct task_t*  MutexOwner;
     struct eventR_t Event;
+
+    #if (LIBRERTOS_MUTEX_CEILING != 0)
+        priority_t  Ceiling; /* Ceiling priority, LIBRERTOS_NO_TASK_RUNNING if none. */
+        priority_t  SavedPriority; /* Owner priority before raised to the ceiling. */
+    #endif
+
+    #if (LIBRERTOS_PRIORITY_INHERITANCE != 0)
+        struct taskListNode_t NodeOwner; /* Node in the mutex list of the owner. */
+    #endif
 };
 
 void Mutex_init(struct Mutex_t* o);
 
+#if (LIBRERTOS_MUTEX_CEILING != 0)
+void Mutex_initCeiling(struct Mutex_t* o, priority_t ceiling);
+#endif
+
 bool_t Mutex_unlock(struct Mutex_t* o);
 bool_t Mutex_lock(struct Mutex_t* o);
 bool_t Mutex_lockPend(struct Mutex_t* o, tick_t ticksToWait);
@@ -279,6 +466,29 @@ struct task_t* Mutex_getOwner(const struct Mutex_t* o);
 
 
 
+/* Event bits. Stored in the task event node value, the most significant bit
+ selects wait-all. */
+typedef tick_t eventBits_t;
+
+#define EVENTGROUP_WAITALL ((eventBits_t)((eventBits_t)1 << (sizeof(eventBits_t) * 8U - 1U)))
+
+struct EventGroup_t {
+    eventBits_t     Bits;
+    struct eventR_t Event;
+};
+
+void EventGroup_init(struct EventGroup_t* o, eventBits_t bits);
+
+eventBits_t EventGroup_set(struct EventGroup_t* o, eventBits_t bits);
+eventBits_t EventGroup_clear(struct EventGroup_t* o, eventBits_t bits);
+eventBits_t EventGroup_get(const struct EventGroup_t* o);
+
+bool_t EventGroup_wait(struct EventGroup_t* o, eventBits_t bits);
+bool_t EventGroup_waitPend(struct EventGroup_t* o, eventBits_t bits, tick_t ticksToWait);
+void EventGroup_pend(struct EventGroup_t* o, eventBits_t bits, tick_t ticksToWait);
+
+
+
 struct Queue_t {
     len_t             ItemSize;
     len_t             Free;
@@ -302,6 +512,16 @@ bool_t Queue_write(struct Queue_t* o, const void* buff);
 bool_t Queue_writePend(struct Queue_t* o, const void* buff, tick_t ticksToWait);
 void Queue_pendWrite(struct Queue_t* o, tick_t ticksToWait);
 
+len_t Queue_readMany(struct Queue_t* o, void* buff, len_t num);
+len_t Queue_readManyPend(struct Queue_t* o, void* buff, len_t num, tick_t ticksToWait);
+len_t Queue_writeMany(struct Queue_t* o, const void* buff, len_t num);
+len_t Queue_writeManyPend(struct Queue_t* o, const void* buff, len_t num, tick_t ticksToWait);
+
+void* Queue_reserveWrite(struct Queue_t* o);
+void Queue_commitWrite(struct Queue_t* o, void* item);
+void* Queue_peekRead(struct Queue_t* o);
+void Queue_releaseRead(struct Queue_t* o, const void* item);
+
 len_t Queue_used(const struct Queue_t *o);
 len_t Queue_free(const struct Queue_t *o);
 len_t Queue_length(const struct Queue_t *o);
@@ -312,6 +532,8 @@ len_t Queue_itemSize(const struct Queue_t *o);
 
 
 
+#if (LIBRERTOS_FIFO_POW2 == 0)
+
 struct Fifo_t {
     len_t             Length;
     len_t             Free;
@@ -322,21 +544,52 @@ struct Fifo_t {
     uint8_t*          Tail;
     uint8_t*          Buff;
     uint8_t*          BufEnd;
+    len_t             Scanned; /* Characters searched for ScanDelim. */
+    uint8_t           ScanDelim;
+    struct eventRw_t  Event;
+};
+
+#else
+
+struct Fifo_t {
+    len_t             Length; /* Power of two. */
+    len_t             WLock;
+    len_t             RLock;
+    #if (LIBRERTOS_FIFO_SPSC == 0)
+        len_t         Head; /* Read cursor (free running, masked to index). */
+        len_t         Tail; /* Write cursor (free running, masked to index). */
+    #else
+        volatile len_t Head; /* Read cursor. Changed only by the reader. */
+        volatile len_t Tail; /* Write cursor. Changed only by the writer. */
+    #endif
+    uint8_t*          Buff;
+    len_t             Scanned; /* Cursor up to where ScanDelim was searched. */
+    uint8_t           ScanDelim;
     struct eventRw_t  Event;
 };
 
+#endif
+
 void Fifo_init(struct Fifo_t *o, void *buff, len_t length);
 
 bool_t Fifo_readByte(struct Fifo_t* o, void* buff);
 len_t Fifo_read(struct Fifo_t* o, void* buff, len_t length);
 len_t Fifo_readPend(struct Fifo_t* o, void* buff, len_t length, tick_t ticksToWait);
 void Fifo_pendRead(struct Fifo_t* o, len_t length, tick_t ticksToWait);
+len_t Fifo_readUntil(struct Fifo_t* o, void* buff, len_t length, uint8_t delim);
+len_t Fifo_readUntilPend(struct Fifo_t* o, void* buff, len_t length, uint8_t delim, tick_t ticksToWait);
+void Fifo_pendReadUntil(struct Fifo_t* o, uint8_t delim, tick_t ticksToWait);
 
 bool_t Fifo_writeByte(struct Fifo_t* o, const void* buff);
 len_t Fifo_write(struct Fifo_t* o, const void* buff, len_t length);
 len_t Fifo_writePend(struct Fifo_t* o, const void* buff, len_t length, tick_t ticksToWait);
 void Fifo_pendWrite(struct Fifo_t* o, len_t length, tick_t ticksToWait);
 
+void* Fifo_getWriteSpan(struct Fifo_t* o, len_t* length);
+void Fifo_commitWrite(struct Fifo_t* o, len_t length);
+const void* Fifo_getReadSpan(struct Fifo_t* o, len_t* length);
+void Fifo_consume(struct Fifo_t* o, len_t length);
+
 len_t Fifo_used(const struct Fifo_t *o);
 len_t Fifo_free(const struct Fifo_t *o);
 len_t Fifo_length(const struct Fifo_t *o);
@@ -346,6 +599,90 @@ len_t Fifo_length(const struct Fifo_t *o);
 
 
 
+struct MsgBuffer_t {
+    len_t             Length;
+    len_t             Free;
+    len_t             Used;
+    len_t             WLock;
+    len_t             RLock;
+    len_t             WNum; /* Messages being written. */
+    len_t             Head;
+    len_t             Tail;
+    uint8_t*          Buff;
+    struct eventRw_t  Event;
+};
+
+void MsgBuffer_init(struct MsgBuffer_t* o, void* buff, len_t length);
+
+len_t MsgBuffer_read(struct MsgBuffer_t* o, void* buff, len_t length);
+len_t MsgBuffer_readPend(struct MsgBuffer_t* o, void* buff, len_t length, tick_t ticksToWait);
+void MsgBuffer_pendRead(struct MsgBuffer_t* o, tick_t ticksToWait);
+
+bool_t MsgBuffer_write(struct MsgBuffer_t* o, const void* buff, len_t length);
+bool_t MsgBuffer_writePend(struct MsgBuffer_t* o, const void* buff, len_t length, tick_t ticksToWait);
+void MsgBuffer_pendWrite(struct MsgBuffer_t* o, len_t length, tick_t ticksToWait);
+
+len_t MsgBuffer_nextLength(const struct MsgBuffer_t* o);
+len_t MsgBuffer_free(const struct MsgBuffer_t* o);
+
+#define MsgBuffer_empty(o) (MsgBuffer_nextLength(o) == 0)
+
+
+
+struct Pool_t {
+    void*             FreeList;
+    len_t             Free;
+    len_t             Length;
+    len_t             BlockSize;
+    struct eventR_t   Event;
+};
+
+void Pool_init(struct Pool_t* o, void* buff, len_t length, len_t block_size);
+
+void* Pool_alloc(struct Pool_t* o);
+void* Pool_allocPend(struct Pool_t* o, tick_t ticksToWait);
+void Pool_pend(struct Pool_t* o, tick_t ticksToWait);
+
+void Pool_free(struct Pool_t* o, void* block);
+
+len_t Pool_getFree(const struct Pool_t* o);
+len_t Pool_length(const struct Pool_t* o);
+len_t Pool_blockSize(const struct Pool_t* o);
+
+
+
+#if (LIBRERTOS_QUEUESET != 0)
+
+enum queueSetType_t {
+    QUEUESET_QUEUE     = 0x00, /* Queue_t can be read. */
+    QUEUESET_FIFO      = 0x01, /* Fifo_t can be read. */
+    QUEUESET_SEMAPHORE = 0x02, /* Semaphore_t can be taken. */
+    QUEUESET_MUTEX     = 0x03  /* Mutex_t can be locked. */
+};
+
+struct QueueSetMember_t {
+    struct taskListNode_t NodeEvent; /* Pends on the object event list. */
+    void*                 Object;
+    enum queueSetType_t   Type;
+};
+
+struct QueueSet_t {
+    struct QueueSetMember_t* Members;
+    len_t                    Length;
+    len_t                    Num;
+};
+
+void QueueSet_init(struct QueueSet_t* o, struct QueueSetMember_t* members, len_t length);
+void QueueSet_add(struct QueueSet_t* o, void* object, enum queueSetType_t type);
+
+void* QueueSet_select(struct QueueSet_t* o);
+void* QueueSet_selectPend(struct QueueSet_t* o, tick_t ticksToWait);
+void QueueSet_pend(struct QueueSet_t* o, tick_t ticksToWait);
+
+#endif
+
+
+
 #define LIBRERTOS_NO_TASK_RUNNING  -1
 
 #ifdef __cplusplus
@@ -0,0 +1,162 @@
+/*
+ LibreRTOS - Portable single-stack Real Time Operating System.
+
+ C++ wrappers. Typed queue, character FIFO and semaphore that own their
+ storage. Header-only, needs C++11 (no standard library, works on AVR).
+
+ Copyright 2016 Djones A. Boni
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#ifndef LIBRERTOS_HPP_
+#define LIBRERTOS_HPP_
+
+#include "LibreRTOS.h"
+
+namespace librertos {
+
+/* Check if n is a power of two (and not zero). */
+constexpr bool isPowerOfTwo(len_t n)
+{
+    return n != 0U && (n & (n - 1U)) == 0U;
+}
+
+/* Check if n fits in len_t. */
+constexpr bool fitsLen(unsigned long long n)
+{
+    return n <= (len_t)-1;
+}
+
+/** Queue of N items of type T.
+
+ T is copied with memcpy(), so it must be trivially copyable. With
+ LIBRERTOS_QUEUE_SMALL_ITEMS items of 1, 2, 4 and 8 bytes (pointers and
+ words) take the small-item path.
+
+ Queue of 4 pointers:
+ librertos::Queue<Packet*, 4> que;
+ que.write(pkt);
+ Packet* pkt;
+ if(que.read(pkt))
+     use_packet(pkt);
+ */
+template<typename T, len_t N>
+class Queue {
+    static_assert(N != 0U, "Queue length must not be zero.");
+    static_assert(fitsLen(sizeof(T)), "Queue item does not fit in len_t.");
+    static_assert(fitsLen((unsigned long long)N * sizeof(T)), "Queue buffer does not fit in len_t.");
+
+public:
+    Queue() { Queue_init(&o, buff, N, (len_t)sizeof(T)); }
+    Queue(const Queue&) = delete;
+    Queue& operator=(const Queue&) = delete;
+
+    bool read(T& item) { return Queue_read(&o, &item) != 0; }
+    bool readPend(T& item, tick_t ticksToWait) { return Queue_readPend(&o, &item, ticksToWait) != 0; }
+    void pendRead(tick_t ticksToWait) { Queue_pendRead(&o, ticksToWait); }
+
+    bool write(const T& item) { return Queue_write(&o, &item) != 0; }
+    bool writePend(const T& item, tick_t ticksToWait) { return Queue_writePend(&o, &item, ticksToWait) != 0; }
+    void pendWrite(tick_t ticksToWait) { Queue_pendWrite(&o, ticksToWait); }
+
+    len_t used() const { return Queue_used(&o); }
+    len_t free() const { return Queue_free(&o); }
+    static constexpr len_t length() { return N; }
+    bool empty() const { return used() == 0U; }
+    bool full() const { return free() == 0U; }
+
+    /* C object, for the C API (queue sets and so on). */
+    struct Queue_t* get() { return &o; }
+
+private:
+    struct Queue_t o;
+    T buff[N];
+};
+
+/** Character FIFO of N characters.
+
+ N must be a power of two with LIBRERTOS_FIFO_POW2.
+
+ Character FIFO of 64 characters:
+ librertos::Fifo<64> fifo;
+ fifo.write("abc", 3);
+ */
+template<len_t N>
+class Fifo {
+    static_assert(N != 0U, "Fifo length must not be zero.");
+    static_assert(LIBRERTOS_FIFO_POW2 == 0 || isPowerOfTwo(N),
+            "Fifo length must be a power of two with LIBRERTOS_FIFO_POW2.");
+
+public:
+    Fifo() { Fifo_init(&o, buff, N); }
+    Fifo(const Fifo&) = delete;
+    Fifo& operator=(const Fifo&) = delete;
+
+    bool readByte(uint8_t& ch) { return Fifo_readByte(&o, &ch) != 0; }
+    len_t read(void* buffer, len_t length) { return Fifo_read(&o, buffer, length); }
+    len_t readPend(void* buffer, len_t length, tick_t ticksToWait) { return Fifo_readPend(&o, buffer, length, ticksToWait); }
+    void pendRead(len_t length, tick_t ticksToWait) { Fifo_pendRead(&o, length, ticksToWait); }
+    len_t readUntil(void* buffer, len_t length, uint8_t delim) { return Fifo_readUntil(&o, buffer, length, delim); }
+    len_t readUntilPend(void* buffer, len_t length, uint8_t delim, tick_t ticksToWait) { return Fifo_readUntilPend(&o, buffer, length, delim, ticksToWait); }
+
+    bool writeByte(uint8_t ch) { return Fifo_writeByte(&o, &ch) != 0; }
+    len_t write(const void* buffer, len_t length) { return Fifo_write(&o, buffer, length); }
+    len_t writePend(const void* buffer, len_t length, tick_t ticksToWait) { return Fifo_writePend(&o, buffer, length, ticksToWait); }
+    void pendWrite(len_t length, tick_t ticksToWait) { Fifo_pendWrite(&o, length, ticksToWait); }
+
+    len_t used() const { return Fifo_used(&o); }
+    len_t free() const { return Fifo_free(&o); }
+    static constexpr len_t length() { return N; }
+    bool empty() const { return used() == 0U; }
+    bool full() const { return free() == 0U; }
+
+    /* C object, for the C API (spans, queue sets and so on). */
+    struct Fifo_t* get() { return &o; }
+
+private:
+    struct Fifo_t o;
+    uint8_t buff[N];
+};
+
+/** Semaphore.
+
+ Binary semaphore, given:
+ librertos::Semaphore sem(1, 1);
+ if(sem.take())
+     do_something();
+ */
+class Semaphore {
+public:
+    Semaphore(len_t count, len_t max) { Semaphore_init(&o, count, max); }
+    Semaphore(const Semaphore&) = delete;
+    Semaphore& operator=(const Semaphore&) = delete;
+
+    bool take() { return Semaphore_take(&o) != 0; }
+    bool takePend(tick_t ticksToWait) { return Semaphore_takePend(&o, ticksToWait) != 0; }
+    void pend(tick_t ticksToWait) { Semaphore_pend(&o, ticksToWait); }
+    bool give() { return Semaphore_give(&o) != 0; }
+
+    len_t getCount() const { return Semaphore_getCount(&o); }
+    len_t getMax() const { return Semaphore_getMax(&o); }
+
+    /* C object, for the C API (queue sets and so on). */
+    struct Semaphore_t* get() { return &o; }
+
+private:
+    struct Semaphore_t o;
+};
+
+} /* namespace librertos */
+
+#endif /* LIBRERTOS_HPP_ */
@@ -37,12 +37,32 @@ void OS_eventPrePendTask(
         struct taskHeadList_t* list,
         struct task_t* task);
 
+void OS_eventPendNode(
+        struct taskHeadList_t* list,
+        struct taskListNode_t* node,
+        priority_t priority);
+
 void OS_eventPendTask(
         struct taskHeadList_t* list,
         struct task_t* task,
         tick_t ticksToWait);
 
 void OS_eventUnblockTasks(struct taskHeadList_t* list);
+void OS_eventUnblockNode(struct taskListNode_t* node);
+void OS_eventUnblockTasksNum(struct taskHeadList_t* list, len_t num);
+void OS_eventUnblockTasksBudget(struct taskHeadList_t* list, len_t budget);
+
+#if (LIBRERTOS_QUEUESET != 0)
+void OS_eventBlockTask(struct task_t* task, tick_t ticksToWait);
+#endif
+
+#if (LIBRERTOS_PRIORITY_INHERITANCE != 0 || LIBRERTOS_MUTEX_CEILING != 0)
+void OS_taskSetPriority(struct task_t* task, priority_t priority);
+#endif
+
+#if (LIBRERTOS_PRIORITY_INHERITANCE != 0)
+void OS_taskInheritPriority(struct task_t* task);
+#endif
 
 #ifdef __cplusplus
 }
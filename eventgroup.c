@@ -0,0 +1,237 @@
+/*
+ LibreRTOS - Portable single-stack Real Time Operating System.
+
+ Event group. Event bits that tasks can wait for, any or all of them.
+
+ Copyright 2016 Djones A. Boni
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#include "LibreRTOS.h"
+#include "OSevent.h"
+
+#define EVENTGROUP_BITS ((eventBits_t)~EVENTGROUP_WAITALL)
+
+/* Check if the event bits satisfy the wanted bits. Wanted bits with
+ EVENTGROUP_WAITALL need all bits set, otherwise any of them. */
+static bool_t _EventGroup_satisfied(eventBits_t current, eventBits_t wanted)
+{
+    eventBits_t mask = (eventBits_t)(wanted & EVENTGROUP_BITS);
+
+    if((wanted & EVENTGROUP_WAITALL) != 0)
+    {
+        return (current & mask) == mask;
+    }
+    else
+    {
+        return (current & mask) != 0;
+    }
+}
+
+/** Initialize event group.
+
+ @param bits Initial event bits. The most significant bit is not available
+ (used by EVENTGROUP_WAITALL).
+
+ Event group with all bits cleared:
+ EventGroup_init(&grp, 0)
+ */
+void EventGroup_init(struct EventGroup_t* o, eventBits_t bits)
+{
+    o->Bits = (eventBits_t)(bits & EVENTGROUP_BITS);
+    OS_eventRInit(&o->Event);
+}
+
+/** Set event bits.
+
+ Unblock all tasks waiting for the event bits that are satisfied, in one
+ scheduler unlock.
+
+ @return Event bits after setting.
+
+ Set bits 0 and 2:
+ EventGroup_set(&grp, 0x05)
+ */
+eventBits_t EventGroup_set(struct EventGroup_t* o, eventBits_t bits)
+{
+    eventBits_t val;
+    CRITICAL_VAL();
+
+    CRITICAL_ENTER();
+    {
+        o->Bits = (eventBits_t)(o->Bits | (bits & EVENTGROUP_BITS));
+        val = o->Bits;
+
+        OS_schedulerLock();
+
+        /* Unblock tasks waiting for the bits (wanted bits in the event node
+         value). */
+        {
+            listlen_t num = o->Event.ListRead.Length;
+            struct taskListNode_t* node = o->Event.ListRead.Head;
+
+            while(num != 0)
+            {
+                struct taskListNode_t* next = node->Next;
+
+                if(_EventGroup_satisfied(val, (eventBits_t)node->Value) != 0)
+                {
+                    OS_eventUnblockNode(node);
+                }
+
+                node = next;
+                --num;
+            }
+        }
+    }
+    CRITICAL_EXIT();
+
+    OS_schedulerUnlock();
+
+    return val;
+}
+
+/** Clear event bits.
+
+ @return Event bits before clearing.
+
+ Clear bits 0 and 2:
+ EventGroup_clear(&grp, 0x05)
+ */
+eventBits_t EventGroup_clear(struct EventGroup_t* o, eventBits_t bits)
+{
+    eventBits_t val;
+    CRITICAL_VAL();
+
+    CRITICAL_ENTER();
+    {
+        val = o->Bits;
+        o->Bits = (eventBits_t)(val & ~bits);
+    }
+    CRITICAL_EXIT();
+
+    return val;
+}
+
+/** Get event bits.
+
+ @return Event bits.
+
+ Get event bits:
+ EventGroup_get(&grp)
+ */
+eventBits_t EventGroup_get(const struct EventGroup_t* o)
+{
+    eventBits_t val;
+    CRITICAL_VAL();
+    CRITICAL_ENTER();
+    {
+        val = o->Bits;
+    }
+    CRITICAL_EXIT();
+    return val;
+}
+
+/** Check event bits.
+
+ Succeed if any of the bits is set, or all of them if bits has
+ EVENTGROUP_WAITALL. The bits are not cleared.
+
+ @return 1 if success, 0 otherwise.
+
+ Wait for bit 0 or bit 2:
+ EventGroup_wait(&grp, 0x05)
+
+ Wait for bit 0 and bit 2:
+ EventGroup_wait(&grp, 0x05 | EVENTGROUP_WAITALL)
+ */
+bool_t EventGroup_wait(struct EventGroup_t* o, eventBits_t bits)
+{
+    bool_t val;
+    CRITICAL_VAL();
+
+    CRITICAL_ENTER();
+    {
+        val = _EventGroup_satisfied(o->Bits, bits);
+    }
+    CRITICAL_EXIT();
+
+    return val;
+}
+
+/** Check or pend on event bits.
+
+ Check event bits; pend on them if not successful.
+
+ Can be called only by tasks.
+
+ The task will not run until the event bits are set or the timeout expires.
+
+ @param ticksToWait Number of ticks the task will wait for the event bits
+ (timeout). Passing MAX_DELAY the task will not wakeup by timeout.
+ @return 1 if success, 0 otherwise.
+
+ Check or pend on bit 0 and bit 2 without timeout:
+ EventGroup_waitPend(&grp, 0x05 | EVENTGROUP_WAITALL, MAX_DELAY)
+
+ Check or pend on bit 0 or bit 2 with timeout of 10 ticks:
+ EventGroup_waitPend(&grp, 0x05, 10)
+ */
+bool_t EventGroup_waitPend(struct EventGroup_t* o, eventBits_t bits, tick_t ticksToWait)
+{
+    bool_t val = EventGroup_wait(o, bits);
+    if(val == 0)
+    {
+        EventGroup_pend(o, bits, ticksToWait);
+    }
+    return val;
+}
+
+/** Pend on event bits.
+
+ Can be called only by tasks.
+
+ The task will not run until the event bits are set or the timeout expires.
+
+ @param ticksToWait Number of ticks the task will wait for the event bits
+ (timeout). Passing MAX_DELAY the task will not wakeup by timeout.
+
+ Pend on bit 0 or bit 2 without timeout:
+ EventGroup_pend(&grp, 0x05, MAX_DELAY)
+
+ Pend on bit 0 and bit 2 with timeout of 10 ticks:
+ EventGroup_pend(&grp, 0x05 | EVENTGROUP_WAITALL, 10)
+ */
+void EventGroup_pend(struct EventGroup_t* o, eventBits_t bits, tick_t ticksToWait)
+{
+    if(ticksToWait != 0U)
+    {
+        struct task_t* task = OS_getCurrentTask();
+
+        OS_schedulerLock();
+        INTERRUPTS_DISABLE();
+        if(_EventGroup_satisfied(o->Bits, bits) == 0)
+        {
+            task->NodeEvent.Value = (tick_t)bits; /* Bits waiting for. */
+            OS_eventPrePendTask(&o->Event.ListRead, task);
+            INTERRUPTS_ENABLE();
+            OS_eventPendTask(&o->Event.ListRead, task, ticksToWait);
+        }
+        else
+        {
+            INTERRUPTS_ENABLE();
+        }
+        OS_schedulerUnlock();
+    }
+}
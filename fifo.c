@@ -23,12 +23,182 @@
 #include "OSevent.h"
 #include <string.h>
 
+#if (LIBRERTOS_FIFO_POW2 == 0)
+    #define FIFO_USED(o) ((o)->Used)
+    #define FIFO_FREE(o) ((o)->Free)
+#else
+    /* Used and free characters derived from the free-running cursors. */
+    #define FIFO_USED(o) ((len_t)((o)->Tail - (o)->WLock - (o)->Head))
+    #define FIFO_FREE(o) ((len_t)((o)->Length - (len_t)((o)->Tail - (o)->Head) - (o)->RLock))
+    #define FIFO_INDEX(o, cursor) ((len_t)((cursor) & ((o)->Length - 1U)))
+#endif
+
+#if (LIBRERTOS_FIFO_POW2 == 0)
+    /* Number of used characters already searched for the delimiter ScanDelim.
+     Decreased as the characters are consumed. */
+    #define FIFO_SCANNED(o) ((o)->Scanned)
+    #define FIFO_SET_SCANNED(o, num) ((o)->Scanned = (num))
+#else
+    /* Cursor up to where the characters were already searched for the
+     delimiter ScanDelim. Stale (larger than used) once the read cursor
+     passes it. */
+    #define FIFO_SCANNED(o) ((len_t)((o)->Scanned - (o)->Head))
+    #define FIFO_SET_SCANNED(o, num) ((o)->Scanned = (len_t)((o)->Head + (num)))
+#endif
+
+/* Task waiting for a delimiter (in the low byte of the event node value)
+ instead of a number of characters. */
+#define FIFO_UNTIL ((tick_t)((tick_t)1 << (sizeof(tick_t) * 8U - 1U)))
+
+/* Search num used characters, after skipping offset ones, for the delimiter.
+ @return Number of characters up to and including the delimiter, 0 if not
+ found. */
+static len_t _Fifo_findDelim(const struct Fifo_t* o, len_t offset, len_t num, uint8_t delim)
+{
+    const uint8_t* pos;
+    const uint8_t* found;
+    size_t index;
+    len_t toEnd;
+
+    #if (LIBRERTOS_FIFO_POW2 == 0)
+    {
+        index = (size_t)(o->Head - o->Buff) + offset;
+        if(index >= o->Length)
+        {
+            index -= o->Length;
+        }
+    }
+    #else
+    {
+        index = FIFO_INDEX(o, (len_t)(o->Head + offset));
+    }
+    #endif
+
+    pos = &o->Buff[index];
+    toEnd = (len_t)(o->Length - index);
+
+    if(num <= toEnd)
+    {
+        found = (const uint8_t*)memchr(pos, delim, (size_t)num);
+        return (found != NULL) ? (len_t)(found - pos + 1) : 0U;
+    }
+
+    found = (const uint8_t*)memchr(pos, delim, (size_t)toEnd);
+    if(found != NULL)
+    {
+        return (len_t)(found - pos + 1);
+    }
+
+    found = (const uint8_t*)memchr(o->Buff, delim, (size_t)(num - toEnd));
+    return (found != NULL) ? (len_t)(toEnd + (found - o->Buff) + 1) : 0U;
+}
+
+/* Search the first num used characters for the delimiter, skipping the ones
+ already searched for it, and record how far they were searched. So while the
+ delimiter is not written each character is searched once, and a write searches
+ only the characters it added. Must be called in a critical section.
+ @return Number of characters up to and including the delimiter, 0 if not
+ found. */
+static len_t _Fifo_scanDelim(struct Fifo_t* o, len_t num, uint8_t delim)
+{
+    len_t scanned = 0U;
+    len_t found;
+
+    if(o->ScanDelim == delim)
+    {
+        scanned = FIFO_SCANNED(o);
+        if(scanned > FIFO_USED(o))
+        {
+            scanned = 0U;
+        }
+    }
+
+    if(scanned >= num)
+    {
+        return 0U;
+    }
+
+    found = _Fifo_findDelim(o, scanned, (len_t)(num - scanned), delim);
+    if(found != 0U)
+    {
+        return (len_t)(scanned + found);
+    }
+
+    FIFO_SET_SCANNED(o, num);
+    o->ScanDelim = delim;
+    return 0U;
+}
+
+#if (LIBRERTOS_FIFO_POW2 == 0)
+
+/* Keep the searched characters that were not consumed. Must be called in a
+ critical section. */
+static void _Fifo_scanConsumed(struct Fifo_t* o, len_t num)
+{
+    o->Scanned = (o->Scanned > num) ? (len_t)(o->Scanned - num) : 0U;
+}
+
+#endif
+
+/* Unblock the tasks waiting to read from this event that fit in the used
+ characters. A task waiting for a delimiter fits if the delimiter was written,
+ or the FIFO is full (it would never be written). */
+static void _Fifo_unblockReaders(struct Fifo_t* o)
+{
+    struct taskHeadList_t* list = &(o->Event.ListRead);
+    len_t used = FIFO_USED(o);
+    len_t budget = used;
+
+    while(list->Length != 0)
+    {
+        struct taskListNode_t* node = list->Tail;
+        tick_t value = node->Value;
+        len_t length;
+
+        if((value & FIFO_UNTIL) != 0U)
+        {
+            /* Delimiter waiting for. The first task searches only the
+             characters not searched yet. */
+            if(budget == used)
+            {
+                length = _Fifo_scanDelim(o, used, (uint8_t)value);
+            }
+            else
+            {
+                length = _Fifo_findDelim(o, (len_t)(used - budget), budget, (uint8_t)value);
+            }
+            if(length == 0U && FIFO_FREE(o) == 0U)
+            {
+                length = budget;
+            }
+
+            if(length == 0U)
+            {
+                break;
+            }
+        }
+        else
+        {
+            /* Length waiting for. */
+            length = (len_t)value;
+        }
+
+        if(length > budget)
+        {
+            break;
+        }
+
+        budget = (len_t)(budget - length);
+        OS_eventUnblockNode(node);
+    }
+}
+
 /** Initialize character FIFO.
 
  @param buff Pointer to the memory buffer the FIFO will use. The memory buffer
  must be at least length bytes long.
  @param length Length of the character FIFO (the number of characters it can
- hold).
+ hold). Must be a power of two with LIBRERTOS_FIFO_POW2.
 
  Initialize character FIFO:
  #define FIFOLEN 16
@@ -41,17 +211,33 @@ void Fifo_init(struct Fifo_t *o, void *buff, len_t length)
     uint8_t *buff8 = (uint8_t*)buff;
 
     o->Length = length;
-    o->Free = length;
-    o->Used = 0U;
     o->WLock = 0U;
     o->RLock = 0U;
-    o->Head = buff8;
-    o->Tail = buff8;
     o->Buff = buff8;
-    o->BufEnd = &buff8[length - 1];
+    o->Scanned = 0U;
+    o->ScanDelim = 0U;
+
+    #if (LIBRERTOS_FIFO_POW2 == 0)
+    {
+        o->Free = length;
+        o->Used = 0U;
+        o->Head = buff8;
+        o->Tail = buff8;
+        o->BufEnd = &buff8[length - 1];
+    }
+    #else
+    {
+        ASSERT(length != 0U && (length & (length - 1U)) == 0U);
+        o->Head = 0U;
+        o->Tail = 0U;
+    }
+    #endif
+
     OS_eventRwInit(&o->Event);
 }
 
+#if (LIBRERTOS_FIFO_SPSC == 0)
+
 /** Read one byte from character FIFO.
 
  @param buff Buffer where to write the character being read (and removed) from
@@ -67,31 +253,33 @@ bool_t Fifo_readByte(struct Fifo_t* o, void* buff)
     CRITICAL_VAL();
 
     CRITICAL_ENTER();
-    if(o->Used > 0)
+    if(FIFO_USED(o) > 0)
     {
-        *(uint8_t*)buff = *o->Head;
+        #if (LIBRERTOS_FIFO_POW2 == 0)
+        {
+            *(uint8_t*)buff = *o->Head;
+
+            if((o->Head += 1) > o->BufEnd)
+            {
+                o->Head = o->Buff;
+            }
 
-        if((o->Head += 1) > o->BufEnd)
+            o->Free = (len_t)(o->Free + 1);
+            o->Used = (len_t)(o->Used - 1);
+            _Fifo_scanConsumed(o, 1U);
+        }
+        #else
         {
-            o->Head = o->Buff;
+            *(uint8_t*)buff = o->Buff[FIFO_INDEX(o, o->Head)];
+            o->Head = (len_t)(o->Head + 1U);
         }
-
-        o->Free = (len_t)(o->Free + 1);
-        o->Used = (len_t)(o->Used - 1);
+        #endif
 
         OS_schedulerLock();
 
-        if(o->Event.ListWrite.Length != 0)
-        {
-            /* Unblock task waiting to write to this event. */
-            struct taskListNode_t* node = o->Event.ListWrite.Tail;
-
-            /* Length waiting for. */
-            if((len_t)node->Value <= o->Free)
-            {
-                OS_eventUnblockTasks(&(o->Event.ListWrite));
-            }
-        }
+        /* Unblock the tasks waiting to write to this event that fit in the
+         free characters. */
+        OS_eventUnblockTasksBudget(&(o->Event.ListWrite), FIFO_FREE(o));
 
         CRITICAL_EXIT();
         OS_schedulerUnlock();
@@ -127,7 +315,7 @@ len_t Fifo_read(struct Fifo_t* o, void* buff, len_t length)
 
     CRITICAL_ENTER();
     {
-        val = (o->Used >= length) ? length : o->Used;
+        val = (FIFO_USED(o) >= length) ? length : FIFO_USED(o);
         if(val != 0U)
         {
             uint8_t *pos;
@@ -136,18 +324,39 @@ len_t Fifo_read(struct Fifo_t* o, void* buff, len_t length)
 
             length = val;
 
-            pos = o->Head;
-            numFromBegin = 0;
-            if((o->Head += length) > o->BufEnd)
+            #if (LIBRERTOS_FIFO_POW2 == 0)
             {
-                numFromBegin = (len_t)((pos + length) - (o->BufEnd + 1));
-                length = (len_t)(length - numFromBegin);
-                o->Head -= o->Length;
+                pos = o->Head;
+                numFromBegin = 0;
+                if((o->Head += length) > o->BufEnd)
+                {
+                    numFromBegin = (len_t)((pos + length) - (o->BufEnd + 1));
+                    length = (len_t)(length - numFromBegin);
+                    o->Head -= o->Length;
+                }
+
+                o->Used = (len_t)(o->Used - val);
+                _Fifo_scanConsumed(o, val);
+            }
+            #else
+            {
+                len_t index = FIFO_INDEX(o, o->Head);
+                len_t toEnd = (len_t)(o->Length - index);
+
+                pos = &o->Buff[index];
+                numFromBegin = 0;
+                if(length > toEnd)
+                {
+                    numFromBegin = (len_t)(length - toEnd);
+                    length = toEnd;
+                }
+
+                o->Head = (len_t)(o->Head + val);
             }
+            #endif
 
             lock = o->RLock;
             o->RLock = (len_t)(o->RLock + val);
-            o->Used = (len_t)(o->Used - val);
 
             CRITICAL_EXIT();
             {
@@ -165,23 +374,20 @@ len_t Fifo_read(struct Fifo_t* o, void* buff, len_t length)
 
             if(lock == 0U)
             {
-                o->Free = (len_t)(o->Free + o->RLock);
+                #if (LIBRERTOS_FIFO_POW2 == 0)
+                {
+                    o->Free = (len_t)(o->Free + o->RLock);
+                }
+                #endif
+
                 o->RLock = 0U;
             }
 
             OS_schedulerLock();
 
-            if(o->Event.ListWrite.Length != 0)
-            {
-                /* Unblock task waiting to write to this event. */
-                struct taskListNode_t* node = o->Event.ListWrite.Tail;
-
-                /* Length waiting for. */
-                if((len_t)node->Value <= o->Free)
-                {
-                    OS_eventUnblockTasks(&(o->Event.ListWrite));
-                }
-            }
+            /* Unblock the tasks waiting to write to this event that fit in the
+             free characters. */
+            OS_eventUnblockTasksBudget(&(o->Event.ListWrite), FIFO_FREE(o));
         }
     }
     CRITICAL_EXIT();
@@ -213,31 +419,32 @@ bool_t Fifo_writeByte(struct Fifo_t* o, const void* buff)
     CRITICAL_VAL();
 
     CRITICAL_ENTER();
-    if(o->Free > 0)
+    if(FIFO_FREE(o) > 0)
     {
-        *o->Tail = *(uint8_t*)buff;
+        #if (LIBRERTOS_FIFO_POW2 == 0)
+        {
+            *o->Tail = *(const uint8_t*)buff;
+
+            if((o->Tail += 1) > o->BufEnd)
+            {
+                o->Tail = o->Buff;
+            }
 
-        if((o->Tail += 1) > o->BufEnd)
+            o->Free = (len_t)(o->Free - 1);
+            o->Used = (len_t)(o->Used + 1);
+        }
+        #else
         {
-            o->Tail = o->Buff;
+            o->Buff[FIFO_INDEX(o, o->Tail)] = *(const uint8_t*)buff;
+            o->Tail = (len_t)(o->Tail + 1U);
         }
-
-        o->Free = (len_t)(o->Free - 1);
-        o->Used = (len_t)(o->Used + 1);
+        #endif
 
         OS_schedulerLock();
 
-        if(o->Event.ListRead.Length != 0)
-        {
-            /* Unblock task waiting to read from this event. */
-            struct taskListNode_t* node = o->Event.ListRead.Tail;
-
-            /* Length waiting for. */
-            if((len_t)node->Value <= o->Used)
-            {
-                OS_eventUnblockTasks(&(o->Event.ListRead));
-            }
-        }
+        /* Unblock the tasks waiting to read from this event that fit in the
+         used characters. */
+        _Fifo_unblockReaders(o);
 
         CRITICAL_EXIT();
         OS_schedulerUnlock();
@@ -274,7 +481,7 @@ len_t Fifo_write(struct Fifo_t* o, const void* buff, len_t length)
 
     CRITICAL_ENTER();
     {
-        val = (o->Free >= length) ? length : o->Free;
+        val = (FIFO_FREE(o) >= length) ? length : FIFO_FREE(o);
         if(val != 0U)
         {
             uint8_t *pos;
@@ -283,18 +490,38 @@ len_t Fifo_write(struct Fifo_t* o, const void* buff, len_t length)
 
             length = val;
 
-            pos = o->Tail;
-            numFromBegin = 0;
-            if((o->Tail += length) > o->BufEnd)
+            #if (LIBRERTOS_FIFO_POW2 == 0)
+            {
+                pos = o->Tail;
+                numFromBegin = 0;
+                if((o->Tail += length) > o->BufEnd)
+                {
+                    numFromBegin = (len_t)((pos + length) - (o->BufEnd + 1));
+                    length = (len_t)(length - numFromBegin);
+                    o->Tail -= o->Length;
+                }
+
+                o->Free = (len_t)(o->Free - val);
+            }
+            #else
             {
-                numFromBegin = (len_t)((pos + length) - (o->BufEnd + 1));
-                length = (len_t)(length - numFromBegin);
-                o->Tail -= o->Length;
+                len_t index = FIFO_INDEX(o, o->Tail);
+                len_t toEnd = (len_t)(o->Length - index);
+
+                pos = &o->Buff[index];
+                numFromBegin = 0;
+                if(length > toEnd)
+                {
+                    numFromBegin = (len_t)(length - toEnd);
+                    length = toEnd;
+                }
+
+                o->Tail = (len_t)(o->Tail + val);
             }
+            #endif
 
             lock = o->WLock;
             o->WLock = (len_t)(o->WLock + val);
-            o->Free = (len_t)(o->Free - val);
 
             OS_schedulerLock();
 
@@ -314,21 +541,18 @@ len_t Fifo_write(struct Fifo_t* o, const void* buff, len_t length)
 
             if(lock == 0U)
             {
-                o->Used = (len_t)(o->Used + o->WLock);
-                o->WLock = 0U;
-            }
-
-            if(o->Event.ListRead.Length != 0)
-            {
-                /* Unblock task waiting to read from this event. */
-                struct taskListNode_t* node = o->Event.ListRead.Tail;
-
-                /* Length waiting for. */
-                if((len_t)node->Value <= o->Used)
+                #if (LIBRERTOS_FIFO_POW2 == 0)
                 {
-                    OS_eventUnblockTasks(&(o->Event.ListRead));
+                    o->Used = (len_t)(o->Used + o->WLock);
                 }
+                #endif
+
+                o->WLock = 0U;
             }
+
+            /* Unblock the tasks waiting to read from this event that fit in the
+             used characters. */
+            _Fifo_unblockReaders(o);
         }
     }
     CRITICAL_EXIT();
@@ -341,6 +565,431 @@ len_t Fifo_write(struct Fifo_t* o, const void* buff, len_t length)
     return val;
 }
 
+#else /* LIBRERTOS_FIFO_SPSC */
+
+/* Single-producer/single-consumer character FIFO. Only the reader changes Head
+ and only the writer changes Tail, so reads and writes need no critical section.
+ The kernel is entered only when a task is pending on the other side. */
+
+/** Read one byte from character FIFO. Single reader. */
+bool_t Fifo_readByte(struct Fifo_t* o, void* buff)
+{
+    return (bool_t)(Fifo_read(o, buff, 1U) != 0U);
+}
+
+/** Read from character FIFO. Single reader. */
+len_t Fifo_read(struct Fifo_t* o, void* buff, len_t length)
+{
+    /* Pop front */
+    len_t head = o->Head;
+    len_t numUsed = (len_t)(o->Tail - head);
+    len_t val = (numUsed >= length) ? length : numUsed;
+    CRITICAL_VAL();
+
+    if(val != 0U)
+    {
+        len_t index = FIFO_INDEX(o, head);
+        len_t toEnd = (len_t)(o->Length - index);
+        len_t numFromBegin = 0;
+
+        length = val;
+        if(length > toEnd)
+        {
+            numFromBegin = (len_t)(length - toEnd);
+            length = toEnd;
+        }
+
+        /* Read the characters after reading the write cursor. */
+        MEMORY_BARRIER();
+
+        memcpy(buff, &o->Buff[index], (size_t)length);
+        if(numFromBegin != 0)
+        {
+            memcpy((uint8_t*)buff + length, o->Buff, (size_t)numFromBegin);
+        }
+
+        /* Free the characters after reading them. */
+        MEMORY_BARRIER();
+        o->Head = (len_t)(head + val);
+        MEMORY_BARRIER();
+
+        if(o->Event.ListWrite.Length != 0)
+        {
+            /* A task is pending to write. Enter the kernel to unblock it. */
+            CRITICAL_ENTER();
+            OS_schedulerLock();
+            OS_eventUnblockTasksBudget(&(o->Event.ListWrite), FIFO_FREE(o));
+            CRITICAL_EXIT();
+            OS_schedulerUnlock();
+        }
+    }
+
+    return val;
+}
+
+/** Write one byte to character FIFO. Single writer. */
+bool_t Fifo_writeByte(struct Fifo_t* o, const void* buff)
+{
+    return (bool_t)(Fifo_write(o, buff, 1U) != 0U);
+}
+
+/** Write to character FIFO. Single writer. */
+len_t Fifo_write(struct Fifo_t* o, const void* buff, len_t length)
+{
+    /* Push back */
+    len_t tail = o->Tail;
+    len_t numFree = (len_t)(o->Length - (len_t)(tail - o->Head));
+    len_t val = (numFree >= length) ? length : numFree;
+    CRITICAL_VAL();
+
+    if(val != 0U)
+    {
+        len_t index = FIFO_INDEX(o, tail);
+        len_t toEnd = (len_t)(o->Length - index);
+        len_t numFromBegin = 0;
+
+        length = val;
+        if(length > toEnd)
+        {
+            numFromBegin = (len_t)(length - toEnd);
+            length = toEnd;
+        }
+
+        /* Write the characters after reading the read cursor. */
+        MEMORY_BARRIER();
+
+        memcpy(&o->Buff[index], buff, (size_t)length);
+        if(numFromBegin != 0)
+        {
+            memcpy(o->Buff, (const uint8_t*)buff + length, (size_t)numFromBegin);
+        }
+
+        /* Publish the characters after writing them. */
+        MEMORY_BARRIER();
+        o->Tail = (len_t)(tail + val);
+        MEMORY_BARRIER();
+
+        if(o->Event.ListRead.Length != 0)
+        {
+            /* A task is pending to read. Enter the kernel to unblock it. */
+            CRITICAL_ENTER();
+            OS_schedulerLock();
+            _Fifo_unblockReaders(o);
+            CRITICAL_EXIT();
+            OS_schedulerUnlock();
+        }
+    }
+
+    return val;
+}
+
+#endif /* LIBRERTOS_FIFO_SPSC */
+
+/** Get span to write to character FIFO.
+
+ Get the largest contiguous free region of the character FIFO, so it can be
+ written in place (no copy, e.g. by DMA). The characters are available to be
+ read only after Fifo_commitWrite().
+
+ There must be only one writer while the span is held. The scheduler is not
+ locked.
+
+ @param length Where to store the length of the span.
+ @return Pointer to the span, NULL if the character FIFO is full.
+
+ Write to character FIFO in place:
+ len_t len;
+ uint8_t* span = Fifo_getWriteSpan(&fifo, &len);
+ if(span != NULL)
+ {
+     len = dma_receive(span, len);
+     Fifo_commitWrite(&fifo, len);
+ }
+ */
+void* Fifo_getWriteSpan(struct Fifo_t* o, len_t* length)
+{
+    uint8_t *pos;
+    len_t val;
+    CRITICAL_VAL();
+
+    CRITICAL_ENTER();
+    {
+        #if (LIBRERTOS_FIFO_POW2 == 0)
+        {
+            pos = o->Tail;
+            val = (len_t)((o->BufEnd + 1) - pos);
+        }
+        #else
+        {
+            len_t index = FIFO_INDEX(o, o->Tail);
+            pos = &o->Buff[index];
+            val = (len_t)(o->Length - index);
+        }
+        #endif
+
+        if(val > FIFO_FREE(o))
+        {
+            val = FIFO_FREE(o);
+        }
+    }
+    CRITICAL_EXIT();
+
+    *length = val;
+    return (val != 0U) ? pos : NULL;
+}
+
+/** Commit characters written to character FIFO.
+
+ Make the first length characters of the span got with Fifo_getWriteSpan()
+ available to be read.
+
+ @param length Number of characters written. At most the span length.
+
+ Commit 3 characters written in place:
+ Fifo_commitWrite(&fifo, 3);
+ */
+void Fifo_commitWrite(struct Fifo_t* o, len_t length)
+{
+    CRITICAL_VAL();
+
+    if(length == 0U)
+    {
+        return;
+    }
+
+    CRITICAL_ENTER();
+    {
+        ASSERT(length <= FIFO_FREE(o));
+
+        #if (LIBRERTOS_FIFO_POW2 == 0)
+        {
+            /* The span never wraps around. */
+            if((o->Tail += length) > o->BufEnd)
+            {
+                o->Tail = o->Buff;
+            }
+
+            o->Free = (len_t)(o->Free - length);
+
+            /* A write being copied (interrupted) publishes the characters after
+             its own ones. */
+            if(o->WLock != 0U)
+            {
+                o->WLock = (len_t)(o->WLock + length);
+            }
+            else
+            {
+                o->Used = (len_t)(o->Used + length);
+            }
+        }
+        #else
+        {
+            #if (LIBRERTOS_FIFO_SPSC != 0)
+            {
+                /* Publish the characters after writing them. */
+                MEMORY_BARRIER();
+            }
+            #endif
+
+            o->Tail = (len_t)(o->Tail + length);
+
+            if(o->WLock != 0U)
+            {
+                o->WLock = (len_t)(o->WLock + length);
+            }
+        }
+        #endif
+
+        OS_schedulerLock();
+
+        /* Unblock the tasks waiting to read from this event that fit in the
+         used characters. */
+        _Fifo_unblockReaders(o);
+    }
+    CRITICAL_EXIT();
+
+    OS_schedulerUnlock();
+}
+
+/** Get span to read from character FIFO.
+
+ Get the largest contiguous used region of the character FIFO, so it can be
+ read in place (no copy, e.g. by DMA). The characters are freed to be written
+ only after Fifo_consume().
+
+ There must be only one reader while the span is held. The scheduler is not
+ locked.
+
+ @param length Where to store the length of the span.
+ @return Pointer to the span, NULL if the character FIFO is empty.
+
+ Read from character FIFO in place:
+ len_t len;
+ const uint8_t* span = Fifo_getReadSpan(&fifo, &len);
+ if(span != NULL)
+ {
+     len = dma_send(span, len);
+     Fifo_consume(&fifo, len);
+ }
+ */
+const void* Fifo_getReadSpan(struct Fifo_t* o, len_t* length)
+{
+    const uint8_t *pos;
+    len_t val;
+    CRITICAL_VAL();
+
+    CRITICAL_ENTER();
+    {
+        #if (LIBRERTOS_FIFO_POW2 == 0)
+        {
+            pos = o->Head;
+            val = (len_t)((o->BufEnd + 1) - pos);
+        }
+        #else
+        {
+            len_t index = FIFO_INDEX(o, o->Head);
+            pos = &o->Buff[index];
+            val = (len_t)(o->Length - index);
+        }
+        #endif
+
+        if(val > FIFO_USED(o))
+        {
+            val = FIFO_USED(o);
+        }
+    }
+    CRITICAL_EXIT();
+
+    *length = val;
+    return (val != 0U) ? pos : NULL;
+}
+
+/** Consume characters read from character FIFO.
+
+ Free the first length characters of the span got with Fifo_getReadSpan() to
+ be written.
+
+ @param length Number of characters read. At most the span length.
+
+ Consume 3 characters read in place:
+ Fifo_consume(&fifo, 3);
+ */
+void Fifo_consume(struct Fifo_t* o, len_t length)
+{
+    CRITICAL_VAL();
+
+    if(length == 0U)
+    {
+        return;
+    }
+
+    CRITICAL_ENTER();
+    {
+        ASSERT(length <= FIFO_USED(o));
+
+        #if (LIBRERTOS_FIFO_POW2 == 0)
+        {
+            /* The span never wraps around. */
+            if((o->Head += length) > o->BufEnd)
+            {
+                o->Head = o->Buff;
+            }
+
+            o->Used = (len_t)(o->Used - length);
+            _Fifo_scanConsumed(o, length);
+
+            /* A read being copied (interrupted) frees the characters after its
+             own ones. */
+            if(o->RLock != 0U)
+            {
+                o->RLock = (len_t)(o->RLock + length);
+            }
+            else
+            {
+                o->Free = (len_t)(o->Free + length);
+            }
+        }
+        #else
+        {
+            #if (LIBRERTOS_FIFO_SPSC != 0)
+            {
+                /* Free the characters after reading them. */
+                MEMORY_BARRIER();
+            }
+            #endif
+
+            o->Head = (len_t)(o->Head + length);
+
+            if(o->RLock != 0U)
+            {
+                o->RLock = (len_t)(o->RLock + length);
+            }
+        }
+        #endif
+
+        OS_schedulerLock();
+
+        /* Unblock the tasks waiting to write to this event that fit in the
+         free characters. */
+        OS_eventUnblockTasksBudget(&(o->Event.ListWrite), FIFO_FREE(o));
+    }
+    CRITICAL_EXIT();
+
+    OS_schedulerUnlock();
+}
+
+/** Read from character FIFO until delimiter.
+
+ Remove the characters up to and including the first delimiter from the
+ character FIFO; copy them to the provided buffer. If there is no delimiter in
+ the first length characters, or the character FIFO is full, remove up to
+ length characters (a line that does not fit the buffer).
+
+ There must be only one reader.
+
+ @param buff Buffer where to write the characters being read (and removed) from
+ the character FIFO. Must be at least length bytes long.
+ @param length Maximum number of characters to be read from the character FIFO.
+ @param delim Delimiter character.
+ @return Number of characters read from the character FIFO, 0 if there is no
+ delimiter yet.
+
+ Read a line from character FIFO:
+ #define LINELEN 32
+ uint8_t line[LINELEN];
+ Fifo_readUntil(&fifo, line, LINELEN, '\n');
+ */
+len_t Fifo_readUntil(struct Fifo_t* o, void* buff, len_t length, uint8_t delim)
+{
+    len_t num;
+    CRITICAL_VAL();
+
+    CRITICAL_ENTER();
+    {
+        num = (FIFO_USED(o) >= length) ? length : FIFO_USED(o);
+        if(num != 0U)
+        {
+            len_t found = _Fifo_scanDelim(o, num, delim);
+            if(found != 0U)
+            {
+                num = found;
+            }
+            else if(num != length && FIFO_FREE(o) != 0U)
+            {
+                num = 0U;
+            }
+        }
+    }
+    CRITICAL_EXIT();
+
+    if(num != 0U)
+    {
+        num = Fifo_read(o, buff, num);
+    }
+
+    return num;
+}
+
 /** Read or pend on character FIFO.
 
  Try read the character FIFO; pend on it not successful.
@@ -375,6 +1024,38 @@ len_t Fifo_readPend(struct Fifo_t* o, void* buff, len_t length, tick_t ticksToWa
     return val;
 }
 
+/** Read until delimiter or pend on character FIFO.
+
+ Try read the character FIFO until delimiter; pend on it not successful.
+
+ Can be called only by tasks.
+
+ If the task pends it will not run until the delimiter is written, the
+ character FIFO is full or the timeout expires.
+
+ @param buff Buffer where to write the characters being read (and removed) from
+ the character FIFO. Must be at least length bytes long.
+ @param length Maximum number of characters to be read from the character FIFO.
+ @param delim Delimiter character.
+ @param ticksToWait Number of ticks the task will wait for the character FIFO
+ (timeout). Passing MAX_DELAY the task will not wakeup by timeout.
+ @return Number of characters read from the character FIFO, 0 if there is no
+ delimiter yet.
+
+ Read a line or pend on character FIFO without timeout:
+ uint8_t line[LINELEN];
+ Fifo_readUntilPend(&fifo, line, LINELEN, '\n', MAX_DELAY);
+ */
+len_t Fifo_readUntilPend(struct Fifo_t* o, void* buff, len_t length, uint8_t delim, tick_t ticksToWait)
+{
+    len_t val = Fifo_readUntil(o, buff, length, delim);
+    if(val == 0)
+    {
+        Fifo_pendReadUntil(o, delim, ticksToWait);
+    }
+    return val;
+}
+
 /** Write or pend on character FIFO.
 
  Try write the character FIFO; pend on it not successful.
@@ -436,8 +1117,9 @@ void Fifo_pendRead(struct Fifo_t* o, len_t length, tick_t ticksToWait)
 
         OS_schedulerLock();
         INTERRUPTS_DISABLE();
-        if(o->Used < length)
+        if(FIFO_USED(o) < length)
         {
+            ASSERT(((tick_t)length & FIFO_UNTIL) == 0U);
             task->NodeEvent.Value = (tick_t)length; /* Length waiting for. */
             OS_eventPrePendTask(&o->Event.ListRead, task);
             INTERRUPTS_ENABLE();
@@ -451,6 +1133,47 @@ void Fifo_pendRead(struct Fifo_t* o, len_t length, tick_t ticksToWait)
     }
 }
 
+/** Pend on character FIFO waiting for delimiter.
+
+ Can be called only by tasks.
+
+ The task will not run until the delimiter is written, the character FIFO is
+ full or the timeout expires.
+
+ @param delim Delimiter character.
+ @param ticksToWait Number of ticks the task will wait for the character FIFO
+ (timeout). Passing MAX_DELAY the task will not wakeup by timeout.
+
+ Pend on character FIFO waiting for a line without timeout:
+ Fifo_pendReadUntil(&fifo, '\n', MAX_DELAY);
+
+ Pend on character FIFO waiting for a line with timeout of 10 ticks:
+ Fifo_pendReadUntil(&fifo, '\n', 10);
+ */
+void Fifo_pendReadUntil(struct Fifo_t* o, uint8_t delim, tick_t ticksToWait)
+{
+    if(ticksToWait != 0U)
+    {
+        struct task_t* task = OS_getCurrentTask();
+
+        OS_schedulerLock();
+        INTERRUPTS_DISABLE();
+        if(_Fifo_scanDelim(o, FIFO_USED(o), delim) == 0U &&
+                FIFO_FREE(o) != 0U)
+        {
+            task->NodeEvent.Value = (tick_t)(FIFO_UNTIL | delim); /* Delimiter waiting for. */
+            OS_eventPrePendTask(&o->Event.ListRead, task);
+            INTERRUPTS_ENABLE();
+            OS_eventPendTask(&o->Event.ListRead, task, ticksToWait);
+        }
+        else
+        {
+            INTERRUPTS_ENABLE();
+        }
+        OS_schedulerUnlock();
+    }
+}
+
 /** Pend on character FIFO waiting to write.
 
  Can be called only by tasks.
@@ -476,7 +1199,7 @@ void Fifo_pendWrite(struct Fifo_t* o, len_t length, tick_t ticksToWait)
 
         OS_schedulerLock();
         INTERRUPTS_DISABLE();
-        if(o->Free < length)
+        if(FIFO_FREE(o) < length)
         {
             task->NodeEvent.Value = (tick_t)length; /* Length waiting for. */
             OS_eventPrePendTask(&o->Event.ListWrite, task);
@@ -506,7 +1229,7 @@ len_t Fifo_used(const struct Fifo_t *o)
     CRITICAL_VAL();
     CRITICAL_ENTER();
     {
-        val = o->Used;
+        val = FIFO_USED(o);
     }
     CRITICAL_EXIT();
     return val;
@@ -527,7 +1250,7 @@ len_t Fifo_free(const struct Fifo_t *o)
     CRITICAL_VAL();
     CRITICAL_ENTER();
     {
-        val = o->Free;
+        val = FIFO_FREE(o);
     }
     CRITICAL_EXIT();
     return val;
@@ -0,0 +1,444 @@
+/*
+ LibreRTOS - Portable single-stack Real Time Operating System.
+
+ Message buffer. Variable length messages in a byte ring, each one prefixed by
+ its length. Messages are read and written whole.
+
+ Copyright 2016 Djones A. Boni
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#include "LibreRTOS.h"
+#include "OSevent.h"
+#include <string.h>
+
+/* Length prefix of each message. */
+#define MSGBUFFER_HEADER ((len_t)sizeof(len_t))
+
+/* Advance index by length, wrapping around. */
+static len_t _MsgBuffer_advance(const struct MsgBuffer_t* o, len_t index, len_t length)
+{
+    len_t toEnd = (len_t)(o->Length - index);
+    return (length < toEnd) ? (len_t)(index + length) : (len_t)(length - toEnd);
+}
+
+/* Copy to the ring from index, wrapping around. Return the index after. */
+static len_t _MsgBuffer_copyIn(struct MsgBuffer_t* o, len_t index, const void* buff, len_t length)
+{
+    len_t toEnd = (len_t)(o->Length - index);
+
+    if(length < toEnd)
+    {
+        memcpy(&o->Buff[index], buff, (size_t)length);
+        return (len_t)(index + length);
+    }
+
+    memcpy(&o->Buff[index], buff, (size_t)toEnd);
+    memcpy(o->Buff, (const uint8_t*)buff + toEnd, (size_t)(length - toEnd));
+    return (len_t)(length - toEnd);
+}
+
+/* Copy from the ring from index, wrapping around. Return the index after. */
+static len_t _MsgBuffer_copyOut(const struct MsgBuffer_t* o, len_t index, void* buff, len_t length)
+{
+    len_t toEnd = (len_t)(o->Length - index);
+
+    if(length < toEnd)
+    {
+        memcpy(buff, &o->Buff[index], (size_t)length);
+        return (len_t)(index + length);
+    }
+
+    memcpy(buff, &o->Buff[index], (size_t)toEnd);
+    memcpy((uint8_t*)buff + toEnd, o->Buff, (size_t)(length - toEnd));
+    return (len_t)(length - toEnd);
+}
+
+/* Length of the next message. The message buffer must not be empty. */
+static len_t _MsgBuffer_nextLength(const struct MsgBuffer_t* o)
+{
+    len_t length;
+    (void)_MsgBuffer_copyOut(o, o->Head, &length, MSGBUFFER_HEADER);
+    return length;
+}
+
+/** Initialize message buffer.
+
+ Each message uses its length plus sizeof(len_t) bytes of the buffer.
+
+ @param buff Pointer to the memory buffer the message buffer will use. Must be
+ at least length bytes long.
+ @param length Length of the message buffer in bytes.
+
+ Initialize message buffer:
+ #define MSGBUFLEN 128
+ uint8_t msgBuffer[MSGBUFLEN];
+ struct MsgBuffer_t msgbuf;
+ MsgBuffer_init(&msgbuf, msgBuffer, MSGBUFLEN);
+ */
+void MsgBuffer_init(struct MsgBuffer_t* o, void* buff, len_t length)
+{
+    o->Length = length;
+    o->Free = length;
+    o->Used = 0U;
+    o->WLock = 0U;
+    o->RLock = 0U;
+    o->WNum = 0U;
+    o->Head = 0U;
+    o->Tail = 0U;
+    o->Buff = (uint8_t*)buff;
+    OS_eventRwInit(&o->Event);
+}
+
+/** Read message from message buffer.
+
+ Remove the next message from the message buffer; copy it to the provided
+ buffer. If the message does not fit the buffer it is not removed (use
+ MsgBuffer_nextLength()).
+
+ @param buff Buffer where to write the message being read (and removed) from
+ the message buffer. Must be at least length bytes long.
+ @param length Length of the buffer.
+ @return Length of the message read, 0 if the message buffer is empty or the
+ message does not fit the buffer.
+
+ Read message from message buffer:
+ uint8_t buff[MSGMAX];
+ len_t len = MsgBuffer_read(&msgbuf, buff, MSGMAX);
+ */
+len_t MsgBuffer_read(struct MsgBuffer_t* o, void* buff, len_t length)
+{
+    /* Pop front */
+    len_t val = 0U;
+    CRITICAL_VAL();
+
+    CRITICAL_ENTER();
+    {
+        if(o->Used != 0U)
+        {
+            val = _MsgBuffer_nextLength(o);
+            if(val <= length)
+            {
+                len_t pos;
+                len_t lock;
+                len_t total = (len_t)(val + MSGBUFFER_HEADER);
+
+                pos = _MsgBuffer_advance(o, o->Head, MSGBUFFER_HEADER);
+                o->Head = _MsgBuffer_advance(o, o->Head, total);
+
+                lock = o->RLock;
+                o->RLock = (len_t)(o->RLock + total);
+                o->Used = (len_t)(o->Used - total);
+
+                CRITICAL_EXIT();
+                {
+                    (void)_MsgBuffer_copyOut(o, pos, buff, val);
+
+                    /* For test coverage only. This macro is used as a
+                     deterministic way to create a concurrent access. */
+                    LIBRERTOS_TEST_CONCURRENT_ACCESS();
+                }
+                CRITICAL_ENTER();
+
+                if(lock == 0U)
+                {
+                    o->Free = (len_t)(o->Free + o->RLock);
+                    o->RLock = 0U;
+                }
+
+                OS_schedulerLock();
+
+                /* Unblock the tasks waiting to write to this event that fit in
+                 the free bytes. */
+                OS_eventUnblockTasksBudget(&(o->Event.ListWrite), o->Free);
+            }
+            else
+            {
+                val = 0U;
+            }
+        }
+    }
+    CRITICAL_EXIT();
+
+    if(val != 0U)
+    {
+        OS_schedulerUnlock();
+    }
+
+    return val;
+}
+
+/** Write message to message buffer.
+
+ Add one message to the message buffer, coping it from the provided buffer.
+ The message is written whole or not at all.
+
+ @param buff Buffer from where to read the message being written to the
+ message buffer. Must be at least length bytes long.
+ @param length Length of the message. Must not be zero.
+ @return 1 if success, 0 otherwise.
+
+ Write message to message buffer:
+ MsgBuffer_write(&msgbuf, "hello", 5);
+ */
+bool_t MsgBuffer_write(struct MsgBuffer_t* o, const void* buff, len_t length)
+{
+    /* Push back */
+    bool_t val;
+    len_t total = (len_t)(length + MSGBUFFER_HEADER);
+    CRITICAL_VAL();
+
+    ASSERT(length != 0U);
+
+    CRITICAL_ENTER();
+    {
+        val = (o->Free >= total && total > length);
+        if(val != 0U)
+        {
+            len_t pos;
+            len_t lock;
+            len_t num = 0U;
+
+            pos = o->Tail;
+            o->Tail = _MsgBuffer_advance(o, o->Tail, total);
+
+            lock = o->WLock;
+            o->WLock = (len_t)(o->WLock + total);
+            ++(o->WNum);
+            o->Free = (len_t)(o->Free - total);
+
+            OS_schedulerLock();
+
+            CRITICAL_EXIT();
+            {
+                pos = _MsgBuffer_copyIn(o, pos, &length, MSGBUFFER_HEADER);
+                (void)_MsgBuffer_copyIn(o, pos, buff, length);
+
+                /* For test coverage only. This macro is used as a deterministic
+                 way to create a concurrent access. */
+                LIBRERTOS_TEST_CONCURRENT_ACCESS();
+            }
+            CRITICAL_ENTER();
+
+            if(lock == 0U)
+            {
+                num = o->WNum;
+                o->Used = (len_t)(o->Used + o->WLock);
+                o->WLock = 0U;
+                o->WNum = 0U;
+            }
+
+            /* Unblock one task waiting to read from this event for each message
+             written. Only the outermost write commits messages, also the ones
+             written by interrupts that nested it. */
+            OS_eventUnblockTasksNum(&(o->Event.ListRead), num);
+        }
+    }
+    CRITICAL_EXIT();
+
+    if(val != 0)
+    {
+        OS_schedulerUnlock();
+    }
+
+    return val;
+}
+
+/** Read message or pend on message buffer.
+
+ Try read the message buffer; pend on it if it is empty.
+
+ Can be called only by tasks.
+
+ If the task pends it will not run until a message is written or the timeout
+ expires.
+
+ @param buff Buffer where to write the message being read (and removed) from
+ the message buffer. Must be at least length bytes long.
+ @param length Length of the buffer.
+ @param ticksToWait Number of ticks the task will wait for the message buffer
+ (timeout). Passing MAX_DELAY the task will not wakeup by timeout.
+ @return Length of the message read, 0 otherwise.
+
+ Read message or pend on message buffer without timeout:
+ uint8_t buff[MSGMAX];
+ MsgBuffer_readPend(&msgbuf, buff, MSGMAX, MAX_DELAY);
+
+ Read message or pend on message buffer with timeout of 10 ticks:
+ uint8_t buff[MSGMAX];
+ MsgBuffer_readPend(&msgbuf, buff, MSGMAX, 10);
+ */
+len_t MsgBuffer_readPend(struct MsgBuffer_t* o, void* buff, len_t length, tick_t ticksToWait)
+{
+    len_t val = MsgBuffer_read(o, buff, length);
+    if(val == 0U)
+    {
+        MsgBuffer_pendRead(o, ticksToWait);
+    }
+    return val;
+}
+
+/** Write message or pend on message buffer.
+
+ Try write the message buffer; pend on it not successful.
+
+ Can be called only by tasks.
+
+ If the task pends it will not run until the message buffer has enough free
+ bytes for the message or the timeout expires.
+
+ @param buff Buffer from where to read the message being written to the
+ message buffer. Must be at least length bytes long.
+ @param length Length of the message. Must not be zero.
+ @param ticksToWait Number of ticks the task will wait for the message buffer
+ (timeout). Passing MAX_DELAY the task will not wakeup by timeout.
+ @return 1 if success, 0 otherwise.
+
+ Write message or pend on message buffer without timeout:
+ MsgBuffer_writePend(&msgbuf, buff, len, MAX_DELAY);
+
+ Write message or pend on message buffer with timeout of 10 ticks:
+ MsgBuffer_writePend(&msgbuf, buff, len, 10);
+ */
+bool_t MsgBuffer_writePend(struct MsgBuffer_t* o, const void* buff, len_t length, tick_t ticksToWait)
+{
+    bool_t val = MsgBuffer_write(o, buff, length);
+    if(val == 0)
+    {
+        MsgBuffer_pendWrite(o, length, ticksToWait);
+    }
+    return val;
+}
+
+/** Pend on message buffer waiting to read.
+
+ Can be called only by tasks.
+
+ The task will not run until a message is written or the timeout expires.
+
+ @param ticksToWait Number of ticks the task will wait for the message buffer
+ (timeout). Passing MAX_DELAY the task will not wakeup by timeout.
+
+ Pend on message buffer waiting to read without timeout:
+ MsgBuffer_pendRead(&msgbuf, MAX_DELAY);
+
+ Pend on message buffer waiting to read with timeout of 10 ticks:
+ MsgBuffer_pendRead(&msgbuf, 10);
+ */
+void MsgBuffer_pendRead(struct MsgBuffer_t* o, tick_t ticksToWait)
+{
+    if(ticksToWait != 0U)
+    {
+        struct task_t* task = OS_getCurrentTask();
+
+        OS_schedulerLock();
+        INTERRUPTS_DISABLE();
+        if(o->Used == 0U)
+        {
+            OS_eventPrePendTask(&o->Event.ListRead, task);
+            INTERRUPTS_ENABLE();
+            OS_eventPendTask(&o->Event.ListRead, task, ticksToWait);
+        }
+        else
+        {
+            INTERRUPTS_ENABLE();
+        }
+        OS_schedulerUnlock();
+    }
+}
+
+/** Pend on message buffer waiting to write.
+
+ Can be called only by tasks.
+
+ The task will not run until the message buffer has enough free bytes for a
+ message of length bytes or the timeout expires.
+
+ @param length Length of the message.
+ @param ticksToWait Number of ticks the task will wait for the message buffer
+ (timeout). Passing MAX_DELAY the task will not wakeup by timeout.
+
+ Pend on message buffer waiting to write without timeout:
+ MsgBuffer_pendWrite(&msgbuf, len, MAX_DELAY);
+
+ Pend on message buffer waiting to write with timeout of 10 ticks:
+ MsgBuffer_pendWrite(&msgbuf, len, 10);
+ */
+void MsgBuffer_pendWrite(struct MsgBuffer_t* o, len_t length, tick_t ticksToWait)
+{
+    if(ticksToWait != 0U)
+    {
+        struct task_t* task = OS_getCurrentTask();
+        len_t total = (len_t)(length + MSGBUFFER_HEADER);
+
+        /* The message would never fit. */
+        ASSERT(total > length && total <= o->Length);
+
+        OS_schedulerLock();
+        INTERRUPTS_DISABLE();
+        if(o->Free < total)
+        {
+            task->NodeEvent.Value = (tick_t)total; /* Length waiting for. */
+            OS_eventPrePendTask(&o->Event.ListWrite, task);
+            INTERRUPTS_ENABLE();
+            OS_eventPendTask(&o->Event.ListWrite, task, ticksToWait);
+        }
+        else
+        {
+            INTERRUPTS_ENABLE();
+        }
+        OS_schedulerUnlock();
+    }
+}
+
+/** Get length of the next message on a message buffer.
+
+ @return Length of the next message, 0 if the message buffer is empty.
+
+ Get length of the next message on a message buffer:
+ MsgBuffer_nextLength(&msgbuf)
+ */
+len_t MsgBuffer_nextLength(const struct MsgBuffer_t* o)
+{
+    len_t val = 0U;
+    CRITICAL_VAL();
+    CRITICAL_ENTER();
+    {
+        if(o->Used != 0U)
+        {
+            val = _MsgBuffer_nextLength(o);
+        }
+    }
+    CRITICAL_EXIT();
+    return val;
+}
+
+/** Get the largest message that can be written on a message buffer.
+
+ @return Length of the largest message that can be written, 0 if none.
+
+ Get the largest message that can be written on a message buffer:
+ MsgBuffer_free(&msgbuf)
+ */
+len_t MsgBuffer_free(const struct MsgBuffer_t* o)
+{
+    len_t val;
+    CRITICAL_VAL();
+    CRITICAL_ENTER();
+    {
+        val = (o->Free > MSGBUFFER_HEADER) ? (len_t)(o->Free - MSGBUFFER_HEADER) : 0U;
+    }
+    CRITICAL_EXIT();
+    return val;
+}
@@ -1,7 +1,9 @@
 /*
  LibreRTOS - Portable single-stack Real Time Operating System.
 
- Mutex. Recursive mutex. No priority inheritance mechanism.
+ Mutex. Recursive mutex. Optional priority inheritance
+ (LIBRERTOS_PRIORITY_INHERITANCE) and immediate priority ceiling
+ (LIBRERTOS_MUTEX_CEILING).
 
  Copyright 2016 Djones A. Boni
 
@@ -33,8 +35,49 @@ void Mutex_init(struct Mutex_t* o)
     o->Count = 0;
     o->MutexOwner = MUTEX_NOT_OWNED;
     OS_eventRInit(&o->Event);
+
+    #if (LIBRERTOS_MUTEX_CEILING != 0)
+    {
+        o->Ceiling = LIBRERTOS_NO_TASK_RUNNING;
+        o->SavedPriority = LIBRERTOS_NO_TASK_RUNNING;
+    }
+    #endif
+
+    #if (LIBRERTOS_PRIORITY_INHERITANCE != 0)
+    {
+        OS_listNodeInit(&o->NodeOwner, o);
+    }
+    #endif
 }
 
+#if (LIBRERTOS_MUTEX_CEILING != 0)
+
+/** Initialize priority ceiling mutex.
+
+ The task that locks the mutex runs with the ceiling priority until it
+ completely unlocks it, so no other task that uses the mutex can run while it
+ is locked. Locking it never fails and never pends, as long as the owner
+ unlocks it before it returns or blocks. The ceiling must be at least the
+ highest priority among the tasks that lock the mutex.
+
+ Without LIBRERTOS_READY_LISTS only one task can use each priority, so the
+ ceiling must be a priority with no task. Ceiling mutexes locked by the same
+ task must be unlocked in the reverse order they were locked.
+
+ @param ceiling Priority of the task while it owns the mutex.
+
+ Initialize ceiling mutex:
+ Mutex_initCeiling(&mtx, 3)
+ */
+void Mutex_initCeiling(struct Mutex_t* o, priority_t ceiling)
+{
+    ASSERT(ceiling >= 0 && ceiling < LIBRERTOS_MAX_PRIORITY);
+    Mutex_init(o);
+    o->Ceiling = ceiling;
+}
+
+#endif /* LIBRERTOS_MUTEX_CEILING */
+
 /** Lock mutex.
 
  Can be called only by tasks.
@@ -58,8 +101,43 @@ bool_t Mutex_lock(struct Mutex_t* o)
         val = o->Count == 0 || o->MutexOwner == currentTask;
         if(val != 0)
         {
+            #if (LIBRERTOS_PRIORITY_INHERITANCE != 0)
+            {
+                if(o->Count == 0 && currentTask != NULL)
+                {
+                    OS_listInsertAfter(
+                            &currentTask->MutexList,
+                            (struct taskListNode_t*)&currentTask->MutexList,
+                            &o->NodeOwner);
+                }
+            }
+            #endif
+
+            #if (LIBRERTOS_MUTEX_CEILING != 0)
+            {
+                /* Raise the owner to the ceiling. */
+                if(     o->Count == 0 && currentTask != NULL &&
+                        currentTask->Priority < o->Ceiling)
+                {
+                    o->SavedPriority = currentTask->Priority;
+                    OS_taskSetPriority(currentTask, o->Ceiling);
+                }
+            }
+            #endif
+
             ++o->Count;
             o->MutexOwner = currentTask;
+
+            #if (LIBRERTOS_PRIORITY_INHERITANCE != 0)
+            {
+                /* Inherit the priority of tasks still pending on the mutex. */
+                if(     o->Count == 1 && currentTask != NULL &&
+                        o->Event.ListRead.Length != 0)
+                {
+                    OS_taskInheritPriority(currentTask);
+                }
+            }
+            #endif
         }
     }
     INTERRUPTS_ENABLE();
@@ -95,6 +173,30 @@ bool_t Mutex_unlock(struct Mutex_t* o)
 
             if(o->Count == 0)
             {
+                #if (LIBRERTOS_MUTEX_CEILING != 0)
+                {
+                    /* Return the owner to its priority before the ceiling. */
+                    if(o->SavedPriority != LIBRERTOS_NO_TASK_RUNNING)
+                    {
+                        OS_taskSetPriority(o->MutexOwner, o->SavedPriority);
+                        o->SavedPriority = LIBRERTOS_NO_TASK_RUNNING;
+                    }
+                }
+                #endif
+
+                #if (LIBRERTOS_PRIORITY_INHERITANCE != 0)
+                {
+                    /* Drop the priority inherited from the tasks pending on
+                     this mutex. Before the tasks are unblocked. */
+                    struct task_t* owner = o->MutexOwner;
+                    if(owner != NULL)
+                    {
+                        OS_listRemove(&o->NodeOwner);
+                        OS_taskInheritPriority(owner);
+                    }
+                }
+                #endif
+
                 o->MutexOwner = NULL;
 
                 if(o->Event.ListRead.Length != 0)
@@ -113,6 +215,59 @@ bool_t Mutex_unlock(struct Mutex_t* o)
     return val;
 }
 
+#if (LIBRERTOS_PRIORITY_INHERITANCE != 0)
+
+/* Set the priority of a task to the highest among its base priority, the tasks
+ pending on the mutexes it owns and the ceiling of those mutexes. Tasks pending
+ on a queue set do not count. Used by mutex and by the scheduler when a task
+ stops pending on a mutex. Must be called with interrupts disabled. */
+void OS_taskInheritPriority(struct task_t* task)
+{
+    priority_t priority = task->BasePriority;
+    struct taskListNode_t* node;
+
+    for(    node = task->MutexList.Head;
+            node != (struct taskListNode_t*)&task->MutexList;
+            node = node->Next)
+    {
+        struct Mutex_t* mutex = (struct Mutex_t*)node->Owner;
+        struct taskHeadList_t* list = &mutex->Event.ListRead;
+        struct taskListNode_t* waiter;
+
+        /* The event list is ordered by priority, the highest in the tail. */
+        for(    waiter = list->Tail;
+                waiter != (struct taskListNode_t*)list;
+                waiter = waiter->Previous)
+        {
+            struct task_t* waiterTask = (struct task_t*)waiter->Owner;
+            if(waiter == &waiterTask->NodeEvent)
+            {
+                if(waiterTask->Priority > priority)
+                {
+                    priority = waiterTask->Priority;
+                }
+                break;
+            }
+        }
+
+        #if (LIBRERTOS_MUTEX_CEILING != 0)
+        {
+            if(mutex->Ceiling > priority)
+            {
+                priority = mutex->Ceiling;
+            }
+        }
+        #endif
+    }
+
+    if(priority != task->Priority)
+    {
+        OS_taskSetPriority(task, priority);
+    }
+}
+
+#endif /* LIBRERTOS_PRIORITY_INHERITANCE */
+
 /** Lock or pend on mutex.
 
  Try lock mutex; pend on it not successful.
@@ -166,9 +321,31 @@ void Mutex_pend(struct Mutex_t* o, tick_t ticksToWait)
         INTERRUPTS_DISABLE();
         if(o->Count != 0 && o->MutexOwner != task)
         {
+            #if (LIBRERTOS_PRIORITY_INHERITANCE != 0)
+            {
+                /* The owner gives up the priority of the task when the task
+                 stops pending on the mutex. */
+                task->PendingMutex = o;
+            }
+            #endif
+
             OS_eventPrePendTask(&o->Event.ListRead, task);
             INTERRUPTS_ENABLE();
             OS_eventPendTask(&o->Event.ListRead, task, ticksToWait);
+
+            #if (LIBRERTOS_PRIORITY_INHERITANCE != 0)
+            {
+                /* The owner inherits the priority of the task, if the task is
+                 still waiting for the mutex. */
+                INTERRUPTS_DISABLE();
+                if(     task->NodeEvent.List == &o->Event.ListRead &&
+                        o->MutexOwner != NULL)
+                {
+                    OS_taskInheritPriority(o->MutexOwner);
+                }
+                INTERRUPTS_ENABLE();
+            }
+            #endif
         }
         else
         {
@@ -0,0 +1,240 @@
+/*
+ LibreRTOS - Portable single-stack Real Time Operating System.
+
+ Memory pool. Fixed size memory blocks, allocated and freed in constant time.
+
+ Copyright 2016 Djones A. Boni
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#include "LibreRTOS.h"
+#include "OSevent.h"
+
+/* A free block holds the pointer to the next free block. */
+struct poolBlock_t {
+    struct poolBlock_t* Next;
+};
+
+/** Initialize memory pool.
+
+ @param buff Pointer to the memory buffer the pool will use. Must be at least
+ length * block_size bytes long and aligned for pointers.
+ @param length Number of blocks in the pool.
+ @param block_size Size of each block. Must be at least sizeof(void*) and a
+ multiple of the pointer alignment.
+
+ Initialize memory pool:
+ #define POOLLEN 4
+ #define POOLBSZ 64
+ void* poolBuffer[POOLLEN * POOLBSZ / sizeof(void*)];
+ struct Pool_t pool;
+ Pool_init(&pool, poolBuffer, POOLLEN, POOLBSZ);
+ */
+void Pool_init(struct Pool_t* o, void* buff, len_t length, len_t block_size)
+{
+    uint8_t* block = (uint8_t*)buff;
+    len_t i;
+
+    ASSERT(block_size >= sizeof(struct poolBlock_t));
+    ASSERT(block_size % sizeof(struct poolBlock_t) == 0U);
+
+    o->FreeList = NULL;
+    o->Free = length;
+    o->Length = length;
+    o->BlockSize = block_size;
+
+    /* Link the blocks, the first block in the head of the free list. */
+    for(i = length; i != 0U; --i)
+    {
+        struct poolBlock_t* node = (struct poolBlock_t*)(void*)&block[(size_t)(i - 1U) * block_size];
+        node->Next = (struct poolBlock_t*)o->FreeList;
+        o->FreeList = node;
+    }
+
+    OS_eventRInit(&o->Event);
+}
+
+/** Allocate block from memory pool.
+
+ Can be called by tasks and interrupts.
+
+ @return Pointer to the block (block_size bytes), NULL if the pool is empty.
+
+ Allocate block from memory pool:
+ uint8_t* block = Pool_alloc(&pool);
+ */
+void* Pool_alloc(struct Pool_t* o)
+{
+    struct poolBlock_t* block;
+    CRITICAL_VAL();
+
+    CRITICAL_ENTER();
+    {
+        block = (struct poolBlock_t*)o->FreeList;
+        if(block != NULL)
+        {
+            o->FreeList = block->Next;
+            --(o->Free);
+        }
+    }
+    CRITICAL_EXIT();
+
+    return block;
+}
+
+/** Free block to memory pool.
+
+ Can be called by tasks and interrupts.
+
+ @param block Pointer returned by Pool_alloc().
+
+ Free block to memory pool:
+ Pool_free(&pool, block);
+ */
+void Pool_free(struct Pool_t* o, void* block)
+{
+    struct poolBlock_t* node = (struct poolBlock_t*)block;
+    CRITICAL_VAL();
+
+    ASSERT(block != NULL);
+
+    CRITICAL_ENTER();
+    {
+        node->Next = (struct poolBlock_t*)o->FreeList;
+        o->FreeList = node;
+        ++(o->Free);
+
+        OS_schedulerLock();
+
+        if(o->Event.ListRead.Length != 0)
+        {
+            /* Unblock task waiting to allocate from this event. */
+            OS_eventUnblockTasks(&(o->Event.ListRead));
+        }
+    }
+    CRITICAL_EXIT();
+
+    OS_schedulerUnlock();
+}
+
+/** Allocate block or pend on memory pool.
+
+ Try allocate a block; pend on the pool if it is empty.
+
+ Can be called only by tasks.
+
+ If the task pends it will not run until a block is freed or the timeout
+ expires.
+
+ @param ticksToWait Number of ticks the task will wait for the pool
+ (timeout). Passing MAX_DELAY the task will not wakeup by timeout.
+ @return Pointer to the block, NULL otherwise.
+
+ Allocate block or pend on memory pool without timeout:
+ Pool_allocPend(&pool, MAX_DELAY)
+
+ Allocate block or pend on memory pool with timeout of 10 ticks:
+ Pool_allocPend(&pool, 10)
+ */
+void* Pool_allocPend(struct Pool_t* o, tick_t ticksToWait)
+{
+    void* val = Pool_alloc(o);
+    if(val == NULL)
+    {
+        Pool_pend(o, ticksToWait);
+    }
+    return val;
+}
+
+/** Pend on memory pool.
+
+ Can be called only by tasks.
+
+ The task will not run until a block is freed or the timeout expires.
+
+ @param ticksToWait Number of ticks the task will wait for the pool
+ (timeout). Passing MAX_DELAY the task will not wakeup by timeout.
+
+ Pend on memory pool without timeout:
+ Pool_pend(&pool, MAX_DELAY)
+
+ Pend on memory pool with timeout of 10 ticks:
+ Pool_pend(&pool, 10)
+ */
+void Pool_pend(struct Pool_t* o, tick_t ticksToWait)
+{
+    if(ticksToWait != 0U)
+    {
+        struct task_t* task = OS_getCurrentTask();
+
+        OS_schedulerLock();
+        INTERRUPTS_DISABLE();
+        if(o->Free == 0U)
+        {
+            OS_eventPrePendTask(&o->Event.ListRead, task);
+            INTERRUPTS_ENABLE();
+            OS_eventPendTask(&o->Event.ListRead, task, ticksToWait);
+        }
+        else
+        {
+            INTERRUPTS_ENABLE();
+        }
+        OS_schedulerUnlock();
+    }
+}
+
+/** Get number of free blocks on a memory pool.
+
+ @return Number of free blocks.
+
+ Get number of free blocks on a memory pool:
+ Pool_getFree(&pool)
+ */
+len_t Pool_getFree(const struct Pool_t* o)
+{
+    len_t val;
+    CRITICAL_VAL();
+    CRITICAL_ENTER();
+    {
+        val = o->Free;
+    }
+    CRITICAL_EXIT();
+    return val;
+}
+
+/** Get memory pool length.
+
+ @return Total number of blocks in the pool.
+
+ Get length of a memory pool:
+ Pool_length(&pool)
+ */
+len_t Pool_length(const struct Pool_t* o)
+{
+    /* This value is constant after initialization. No need for locks. */
+    return o->Length;
+}
+
+/** Get memory pool block size.
+
+ @return Size of each block.
+
+ Get block size of a memory pool:
+ Pool_blockSize(&pool)
+ */
+len_t Pool_blockSize(const struct Pool_t* o)
+{
+    /* This value is constant after initialization. No need for locks. */
+    return o->BlockSize;
+}
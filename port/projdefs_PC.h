@@ -30,13 +30,31 @@ extern "C" {
 #define LIBRERTOS_SOFTWARETIMERS     0  /* boolean */
 #define LIBRERTOS_STATE_GUARDS       0  /* boolean */
 #define LIBRERTOS_STATISTICS         0  /* boolean */
+#define LIBRERTOS_READY_BITMAP       0  /* boolean */
+#define LIBRERTOS_READY_LISTS        0  /* boolean */
+#define LIBRERTOS_DELAY_WHEEL        0  /* integer >= 0, power of two (0 disables) */
+#define LIBRERTOS_TIMER_WHEEL        0  /* integer >= 0, power of two (0 disables) */
+#define LIBRERTOS_MONOTONIC_TICK     0  /* boolean (tick_t of 64 bits, never overflows) */
+#define LIBRERTOS_PRIORITY_INHERITANCE 0 /* boolean */
+#define LIBRERTOS_MUTEX_CEILING      0  /* boolean */
+#define LIBRERTOS_TASK_NOTIFY        0  /* boolean */
+#define LIBRERTOS_FIFO_POW2          0  /* boolean (Fifo length power of two) */
+#define LIBRERTOS_FIFO_SPSC          0  /* boolean (one reader, one writer; needs LIBRERTOS_FIFO_POW2 and MEMORY_BARRIER) */
+#define LIBRERTOS_QUEUESET           0  /* boolean */
+#define LIBRERTOS_QUEUE_SMALL_ITEMS  0  /* boolean (copy 1, 2, 4 and 8 byte items in the critical section) */
 
 typedef int8_t   priority_t;
 typedef uint8_t  schedulerLock_t;
+#if (LIBRERTOS_MONOTONIC_TICK != 0)
+typedef uint64_t tick_t;
+typedef int64_t  difftick_t;
+#else
 typedef uint16_t tick_t;
 typedef int16_t  difftick_t;
+#endif
 typedef uint32_t stattime_t;
 typedef uint16_t len_t;
+typedef uint16_t listlen_t;   /* Maximum number of tasks or timers in a list */
 typedef uint8_t  bool_t;
 
 #define MAX_DELAY ((tick_t)-1)
@@ -44,6 +62,17 @@ typedef uint8_t  bool_t;
 /* Assert macro. */
 #define ASSERT(x) assert(x)
 
+/* Count leading zeros of a 32-bit word (ready bitmap). Optional, LibreRTOS has
+ a portable fallback. */
+#if defined(__GNUC__)
+#define LIBRERTOS_CLZ(x) ((uint8_t)__builtin_clz(x))
+#endif
+
+/* Memory barrier. Orders the Fifo data and cursors in LIBRERTOS_FIFO_SPSC. */
+#if defined(__GNUC__)
+#define MEMORY_BARRIER() __sync_synchronize()
+#endif
+
 /* Enable/disable interrupts macros. */
 #define INTERRUPTS_ENABLE()
 #define INTERRUPTS_DISABLE()
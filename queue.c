@@ -22,6 +22,36 @@
 #include "OSevent.h"
 #include <string.h>
 
+#if (LIBRERTOS_QUEUE_SMALL_ITEMS != 0)
+
+/* Items of these sizes (including pointers) are copied inside the critical
+ section. */
+#define QUEUE_SMALL_ITEM(size) \
+        ((size) == 1U || (size) == 2U || (size) == 4U || (size) == 8U)
+
+/* Copy a small item. The constant sizes let the compiler use single loads and
+ stores instead of a memcpy() call. */
+static void _Queue_copySmall(void* dst, const void* src, len_t size)
+{
+    switch(size)
+    {
+    case 1U:
+        *(uint8_t*)dst = *(const uint8_t*)src;
+        break;
+    case 2U:
+        memcpy(dst, src, 2U);
+        break;
+    case 4U:
+        memcpy(dst, src, 4U);
+        break;
+    default:
+        memcpy(dst, src, 8U);
+        break;
+    }
+}
+
+#endif
+
 /** Initialize queue.
 
  @param buff Pointer to the memory buffer the queue will use. Must be at least
@@ -77,6 +107,7 @@ bool_t Queue_read(struct Queue_t* o, void* buff)
         {
             uint8_t *pos;
             len_t lock;
+            len_t num = 0U;
 
             pos = o->Head;
             if((o->Head += o->ItemSize) > o->BufEnd)
@@ -84,32 +115,55 @@ bool_t Queue_read(struct Queue_t* o, void* buff)
                 o->Head = o->Buff;
             }
 
-            lock = (o->RLock)++;
             --(o->Used);
 
-            CRITICAL_EXIT();
+            #if (LIBRERTOS_QUEUE_SMALL_ITEMS != 0)
+            if(QUEUE_SMALL_ITEM(o->ItemSize))
             {
-                memcpy(buff, pos, (size_t)o->ItemSize);
-
-                /* For test coverage only. This macro is used as a deterministic
-                 way to create a concurrent access. */
-                LIBRERTOS_TEST_CONCURRENT_ACCESS();
+                /* Small item. Copy it inside the critical section. */
+                _Queue_copySmall(buff, pos, o->ItemSize);
+
+                if(o->RLock != 0U)
+                {
+                    /* A read being copied (interrupted) frees the item after
+                     its own ones. */
+                    ++(o->RLock);
+                }
+                else
+                {
+                    ++(o->Free);
+                    num = 1U;
+                }
             }
-            CRITICAL_ENTER();
-
-            if(lock == 0U)
+            else
+            #endif
             {
-                o->Free = (len_t)(o->Free + o->RLock);
-                o->RLock = 0U;
+                lock = (o->RLock)++;
+
+                CRITICAL_EXIT();
+                {
+                    memcpy(buff, pos, (size_t)o->ItemSize);
+
+                    /* For test coverage only. This macro is used as a
+                     deterministic way to create a concurrent access. */
+                    LIBRERTOS_TEST_CONCURRENT_ACCESS();
+                }
+                CRITICAL_ENTER();
+
+                if(lock == 0U)
+                {
+                    num = o->RLock;
+                    o->Free = (len_t)(o->Free + num);
+                    o->RLock = 0U;
+                }
             }
 
             OS_schedulerLock();
 
-            if(o->Event.ListWrite.Length != 0)
-            {
-                /* Unblock tasks waiting to write to this event. */
-                OS_eventUnblockTasks(&(o->Event.ListWrite));
-            }
+            /* Unblock one task waiting to write to this event for each item
+             freed. Only the outermost read frees items, also the ones read by
+             interrupts that nested it. */
+            OS_eventUnblockTasksNum(&(o->Event.ListWrite), num);
         }
     }
     CRITICAL_EXIT();
@@ -148,6 +202,7 @@ bool_t Queue_write(struct Queue_t* o, const void* buff)
         {
             uint8_t *pos;
             len_t lock;
+            len_t num = 0U;
 
             pos = o->Tail;
             if((o->Tail += o->ItemSize) > o->BufEnd)
@@ -155,14 +210,120 @@ bool_t Queue_write(struct Queue_t* o, const void* buff)
                 o->Tail = o->Buff;
             }
 
-            lock = (o->WLock)++;
             --(o->Free);
 
             OS_schedulerLock();
 
+            #if (LIBRERTOS_QUEUE_SMALL_ITEMS != 0)
+            if(QUEUE_SMALL_ITEM(o->ItemSize))
+            {
+                /* Small item. Copy it inside the critical section. */
+                _Queue_copySmall(pos, buff, o->ItemSize);
+
+                if(o->WLock != 0U)
+                {
+                    /* A write being copied (interrupted) commits the item
+                     after its own ones. */
+                    ++(o->WLock);
+                }
+                else
+                {
+                    ++(o->Used);
+                    num = 1U;
+                }
+            }
+            else
+            #endif
+            {
+                lock = (o->WLock)++;
+
+                CRITICAL_EXIT();
+                {
+                    memcpy(pos, buff, (size_t)o->ItemSize);
+
+                    /* For test coverage only. This macro is used as a
+                     deterministic way to create a concurrent access. */
+                    LIBRERTOS_TEST_CONCURRENT_ACCESS();
+                }
+                CRITICAL_ENTER();
+
+                if(lock == 0U)
+                {
+                    num = o->WLock;
+                    o->Used = (len_t)(o->Used + num);
+                    o->WLock = 0U;
+                }
+            }
+
+            /* Unblock one task waiting to read from this event for each item
+             written. Only the outermost write commits items, also the ones
+             written by interrupts that nested it. */
+            OS_eventUnblockTasksNum(&(o->Event.ListRead), num);
+        }
+    }
+    CRITICAL_EXIT();
+
+    if(val != 0)
+    {
+        OS_schedulerUnlock();
+    }
+
+    return val;
+}
+
+/** Read items from queue.
+
+ Remove up to num items from the queue; copy them to the provided buffer. Moves
+ all items with at most two copies and one scheduler unlock.
+
+ @param buff Buffer where to write the items being read (and removed) from the
+ queue. Must be at least num * QUEISZ bytes long.
+ @param num Maximum number of items to be read from the queue.
+ @return Number of items read from the queue, 0 if it is empty.
+
+ Read up to 8 items from queue:
+ uint8_t buff[8 * QUEISZ];
+ Queue_readMany(&que, buff, 8);
+ */
+len_t Queue_readMany(struct Queue_t* o, void* buff, len_t num)
+{
+    /* Pop front */
+    len_t val;
+    CRITICAL_VAL();
+
+    CRITICAL_ENTER();
+    {
+        val = (o->Used >= num) ? num : o->Used;
+        if(val != 0U)
+        {
+            uint8_t *pos;
+            size_t length;
+            size_t numFromBegin;
+            len_t lock;
+            len_t freed = 0U;
+
+            length = (size_t)val * (size_t)o->ItemSize;
+
+            pos = o->Head;
+            numFromBegin = 0;
+            if((o->Head += length) > o->BufEnd)
+            {
+                numFromBegin = (size_t)((pos + length) - (o->BufEnd + o->ItemSize));
+                length -= numFromBegin;
+                o->Head -= (o->BufEnd - o->Buff) + o->ItemSize;
+            }
+
+            lock = o->RLock;
+            o->RLock = (len_t)(o->RLock + val);
+            o->Used = (len_t)(o->Used - val);
+
             CRITICAL_EXIT();
             {
-                memcpy(pos, buff, (size_t)o->ItemSize);
+                memcpy(buff, pos, length);
+                if(numFromBegin != 0)
+                {
+                    memcpy((uint8_t*)buff + length, o->Buff, numFromBegin);
+                }
 
                 /* For test coverage only. This macro is used as a deterministic
                  way to create a concurrent access. */
@@ -172,15 +333,101 @@ bool_t Queue_write(struct Queue_t* o, const void* buff)
 
             if(lock == 0U)
             {
-                o->Used = (len_t)(o->Used + o->WLock);
-                o->WLock = 0U;
+                freed = o->RLock;
+                o->Free = (len_t)(o->Free + freed);
+                o->RLock = 0U;
+            }
+
+            OS_schedulerLock();
+
+            /* Unblock one task waiting to write to this event for each item
+             freed. */
+            OS_eventUnblockTasksNum(&(o->Event.ListWrite), freed);
+        }
+    }
+    CRITICAL_EXIT();
+
+    if(val != 0)
+    {
+        OS_schedulerUnlock();
+    }
+
+    return val;
+}
+
+/** Write items to queue.
+
+ Add up to num items to the queue, coping them from the provided buffer. Moves
+ all items with at most two copies and one scheduler unlock.
+
+ @param buff Buffer from where to read the items being written to the queue.
+ Must be at least num * QUEISZ bytes long.
+ @param num Maximum number of items to be written to the queue.
+ @return Number of items written to the queue, 0 if it is full.
+
+ Write up to 8 items to queue:
+ uint8_t buff[8 * QUEISZ];
+ init_buff(buff);
+ Queue_writeMany(&que, buff, 8);
+ */
+len_t Queue_writeMany(struct Queue_t* o, const void* buff, len_t num)
+{
+    /* Push back */
+    len_t val;
+    CRITICAL_VAL();
+
+    CRITICAL_ENTER();
+    {
+        val = (o->Free >= num) ? num : o->Free;
+        if(val != 0U)
+        {
+            uint8_t *pos;
+            size_t length;
+            size_t numFromBegin;
+            len_t lock;
+            len_t committed = 0U;
+
+            length = (size_t)val * (size_t)o->ItemSize;
+
+            pos = o->Tail;
+            numFromBegin = 0;
+            if((o->Tail += length) > o->BufEnd)
+            {
+                numFromBegin = (size_t)((pos + length) - (o->BufEnd + o->ItemSize));
+                length -= numFromBegin;
+                o->Tail -= (o->BufEnd - o->Buff) + o->ItemSize;
+            }
+
+            lock = o->WLock;
+            o->WLock = (len_t)(o->WLock + val);
+            o->Free = (len_t)(o->Free - val);
+
+            OS_schedulerLock();
+
+            CRITICAL_EXIT();
+            {
+                memcpy(pos, buff, length);
+                if(numFromBegin != 0)
+                {
+                    memcpy(o->Buff, (const uint8_t*)buff + length, numFromBegin);
+                }
+
+                /* For test coverage only. This macro is used as a deterministic
+                 way to create a concurrent access. */
+                LIBRERTOS_TEST_CONCURRENT_ACCESS();
             }
+            CRITICAL_ENTER();
 
-            if(o->Event.ListRead.Length != 0)
+            if(lock == 0U)
             {
-                /* Unblock tasks waiting to read from this event. */
-                OS_eventUnblockTasks(&(o->Event.ListRead));
+                committed = o->WLock;
+                o->Used = (len_t)(o->Used + committed);
+                o->WLock = 0U;
             }
+
+            /* Unblock one task waiting to read from this event for each item
+             written. */
+            OS_eventUnblockTasksNum(&(o->Event.ListRead), committed);
         }
     }
     CRITICAL_EXIT();
@@ -193,6 +440,178 @@ bool_t Queue_write(struct Queue_t* o, const void* buff)
     return val;
 }
 
+/* Position of the oldest item not committed, count items before pos. Used by
+ commit write and release read to find the outermost reservation. Must be
+ called in a critical section. */
+static uint8_t* _Queue_oldestReserved(const struct Queue_t* o, uint8_t* pos, len_t count)
+{
+    size_t offset = (size_t)count * (size_t)o->ItemSize;
+
+    if((size_t)(pos - o->Buff) < offset)
+    {
+        /* Wrap around. */
+        pos += (o->BufEnd - o->Buff) + o->ItemSize;
+    }
+
+    return pos - offset;
+}
+
+/** Reserve item to write to queue.
+
+ Reserve one item in the queue and return a pointer to it, so the item can be
+ written in place (no copy). The item is available to be read only after
+ Queue_commitWrite(). The scheduler is locked until then.
+
+ Reservations can be nested (interrupts), but must be committed in the reverse
+ order they were reserved.
+
+ @return Pointer to the reserved item (QUEISZ bytes), NULL if the queue is full.
+
+ Write item to queue in place:
+ uint8_t* item = Queue_reserveWrite(&que);
+ if(item != NULL)
+ {
+     init_buff(item);
+     Queue_commitWrite(&que, item);
+ }
+ */
+void* Queue_reserveWrite(struct Queue_t* o)
+{
+    uint8_t *pos = NULL;
+    CRITICAL_VAL();
+
+    CRITICAL_ENTER();
+    {
+        if(o->Free != 0U)
+        {
+            pos = o->Tail;
+            if((o->Tail += o->ItemSize) > o->BufEnd)
+            {
+                o->Tail = o->Buff;
+            }
+
+            ++(o->WLock);
+            --(o->Free);
+
+            OS_schedulerLock();
+        }
+    }
+    CRITICAL_EXIT();
+
+    return pos;
+}
+
+/** Commit item written to queue.
+
+ Make an item reserved with Queue_reserveWrite() available to be read.
+
+ @param item Pointer returned by Queue_reserveWrite().
+
+ Commit item written in place:
+ Queue_commitWrite(&que, item);
+ */
+void Queue_commitWrite(struct Queue_t* o, void* item)
+{
+    CRITICAL_VAL();
+
+    CRITICAL_ENTER();
+    {
+        /* Only the outermost reservation commits, also the items reserved by
+         interrupts that nested it. */
+        if((uint8_t*)item == _Queue_oldestReserved(o, o->Tail, o->WLock))
+        {
+            len_t num = o->WLock;
+            o->Used = (len_t)(o->Used + num);
+            o->WLock = 0U;
+
+            /* Unblock one task waiting to read from this event for each item
+             written. */
+            OS_eventUnblockTasksNum(&(o->Event.ListRead), num);
+        }
+    }
+    CRITICAL_EXIT();
+
+    OS_schedulerUnlock();
+}
+
+/** Peek item to read from queue.
+
+ Remove one item from the queue and return a pointer to it, so the item can be
+ read in place (no copy). The item is freed to be written only after
+ Queue_releaseRead(). The scheduler is locked until then.
+
+ Peeks can be nested (interrupts), but must be released in the reverse order
+ they were peeked.
+
+ @return Pointer to the item (QUEISZ bytes), NULL if the queue is empty.
+
+ Read item from queue in place:
+ const uint8_t* item = Queue_peekRead(&que);
+ if(item != NULL)
+ {
+     use_buff(item);
+     Queue_releaseRead(&que, item);
+ }
+ */
+void* Queue_peekRead(struct Queue_t* o)
+{
+    uint8_t *pos = NULL;
+    CRITICAL_VAL();
+
+    CRITICAL_ENTER();
+    {
+        if(o->Used != 0U)
+        {
+            pos = o->Head;
+            if((o->Head += o->ItemSize) > o->BufEnd)
+            {
+                o->Head = o->Buff;
+            }
+
+            ++(o->RLock);
+            --(o->Used);
+
+            OS_schedulerLock();
+        }
+    }
+    CRITICAL_EXIT();
+
+    return pos;
+}
+
+/** Release item read from queue.
+
+ Free an item got with Queue_peekRead() to be written.
+
+ @param item Pointer returned by Queue_peekRead().
+
+ Release item read in place:
+ Queue_releaseRead(&que, item);
+ */
+void Queue_releaseRead(struct Queue_t* o, const void* item)
+{
+    CRITICAL_VAL();
+
+    CRITICAL_ENTER();
+    {
+        /* Only the outermost peek frees items, also the items peeked by
+         interrupts that nested it. */
+        if((const uint8_t*)item == _Queue_oldestReserved(o, o->Head, o->RLock))
+        {
+            len_t num = o->RLock;
+            o->Free = (len_t)(o->Free + num);
+            o->RLock = 0U;
+
+            /* Unblock one task waiting to write to this event for each item
+             freed. */
+            OS_eventUnblockTasksNum(&(o->Event.ListWrite), num);
+        }
+    }
+    CRITICAL_EXIT();
+
+    OS_schedulerUnlock();
+}
+
 /** Read or pend on queue.
 
  Try read the queue; pend on it not successful.
@@ -261,6 +680,67 @@ bool_t Queue_writePend(struct Queue_t* o, const void* buff, tick_t ticksToWait)
     return val;
 }
 
+/** Read items or pend on queue.
+
+ Try read up to num items from the queue; pend on it if it is empty.
+
+ Can be called only by tasks.
+
+ If the task pends it will not run until the queue is written or the timeout
+ expires.
+
+ @param buff Buffer where to write the items being read (and removed) from the
+ queue. Must be at least num * QUEISZ bytes long.
+ @param num Maximum number of items to be read from the queue.
+ @param ticksToWait Number of ticks the task will wait for the queue
+ (timeout). Passing MAX_DELAY the task will not wakeup by timeout.
+ @return Number of items read from the queue, 0 if it is empty.
+
+ Read up to 8 items or pend on queue without timeout:
+ uint8_t buff[8 * QUEISZ];
+ Queue_readManyPend(&que, buff, 8, MAX_DELAY);
+ */
+len_t Queue_readManyPend(struct Queue_t* o, void* buff, len_t num, tick_t ticksToWait)
+{
+    len_t val = Queue_readMany(o, buff, num);
+    if(val == 0)
+    {
+        Queue_pendRead(o, ticksToWait);
+    }
+    return val;
+}
+
+/** Write items or pend on queue.
+
+ Try write up to num items to the queue; pend on it if it is full.
+
+ Can be called only by tasks.
+
+ If the task pends it will not run until the queue is read or the timeout
+ expires.
+
+ @param buff Buffer from where to read the items being written to the queue.
+ Must be at least num * QUEISZ bytes long.
+ @param num Maximum number of items to be written to the queue.
+ @param ticksToWait Number of ticks the task will wait for the queue
+ (timeout). Passing MAX_DELAY the task will not wakeup by timeout.
+ @return Number of items written to the queue, 0 if it is full.
+
+ Write up to 8 items or pend on queue without timeout:
+ uint8_t buff[8 * QUEISZ];
+ init_buff(buff);
+ Queue_writeManyPend(&que, buff, 8, MAX_DELAY);
+ */
+len_t Queue_writeManyPend(struct Queue_t* o, const void* buff, len_t num, tick_t ticksToWait)
+{
+    len_t val = Queue_writeMany(o, buff, num);
+    if(val == 0)
+    {
+        Queue_pendWrite(o, ticksToWait);
+    }
+    return val;
+}
+
 /** Pend on queue waiting to read.
 
  Can be called only by tasks.
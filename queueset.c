@@ -0,0 +1,247 @@
+/*
+ LibreRTOS - Portable single-stack Real Time Operating System.
+
+ Queue set. Pend on several queues, fifos, semaphores and mutexes at once.
+
+ Copyright 2016 Djones A. Boni
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#include "LibreRTOS.h"
+#include "OSevent.h"
+
+#if (LIBRERTOS_QUEUESET != 0)
+
+/* Check if the object of a member can be read, taken or locked. */
+static bool_t _QueueSet_ready(const struct QueueSetMember_t* member)
+{
+    switch(member->Type)
+    {
+    case QUEUESET_QUEUE:
+        return Queue_used((const struct Queue_t*)member->Object) != 0U;
+    case QUEUESET_FIFO:
+        return Fifo_used((const struct Fifo_t*)member->Object) != 0U;
+    case QUEUESET_SEMAPHORE:
+        return Semaphore_getCount((const struct Semaphore_t*)member->Object) != 0U;
+    case QUEUESET_MUTEX:
+    default:
+        return  Mutex_getCount((const struct Mutex_t*)member->Object) == 0U ||
+                Mutex_getOwner((const struct Mutex_t*)member->Object) == OS_getCurrentTask();
+    }
+}
+
+/* Event list a member pends on. */
+static struct taskHeadList_t* _QueueSet_list(const struct QueueSetMember_t* member)
+{
+    switch(member->Type)
+    {
+    case QUEUESET_QUEUE:
+        return &((struct Queue_t*)member->Object)->Event.ListRead;
+    case QUEUESET_FIFO:
+        return &((struct Fifo_t*)member->Object)->Event.ListRead;
+    case QUEUESET_SEMAPHORE:
+        return &((struct Semaphore_t*)member->Object)->Event.ListRead;
+    case QUEUESET_MUTEX:
+    default:
+        return &((struct Mutex_t*)member->Object)->Event.ListRead;
+    }
+}
+
+/** Initialize queue set.
+
+ @param members Array of members the queue set will use, one for each object
+ added to the set.
+ @param length Number of members in the array.
+
+ Initialize queue set:
+ #define QSETLEN 4
+ struct QueueSetMember_t qsetMembers[QSETLEN];
+ struct QueueSet_t qset;
+ QueueSet_init(&qset, qsetMembers, QSETLEN);
+ */
+void QueueSet_init(struct QueueSet_t* o, struct QueueSetMember_t* members, len_t length)
+{
+    o->Members = members;
+    o->Length = length;
+    o->Num = 0U;
+}
+
+/** Add object to queue set.
+
+ Only one task may pend on a queue set. Tasks pending on the queue set do not
+ raise the priority of mutex owners (priority inheritance).
+
+ @param object Queue_t, Fifo_t, Semaphore_t or Mutex_t to add.
+ @param type Type of the object.
+
+ Add queue and semaphore to queue set:
+ QueueSet_add(&qset, &que, QUEUESET_QUEUE);
+ QueueSet_add(&qset, &sem, QUEUESET_SEMAPHORE);
+ */
+void QueueSet_add(struct QueueSet_t* o, void* object, enum queueSetType_t type)
+{
+    struct QueueSetMember_t* member;
+
+    ASSERT(o->Num < o->Length);
+
+    member = &o->Members[o->Num];
+    OS_listNodeInit(&member->NodeEvent, NULL);
+    member->NodeEvent.Value = 1U; /* Length waiting for (Fifo_t). */
+    member->Object = object;
+    member->Type = type;
+
+    ++(o->Num);
+}
+
+/** Select object of queue set.
+
+ Find the first object added to the queue set that can be read, taken or
+ locked. The object is not read, taken or locked.
+
+ @return Pointer to the object, NULL if none is ready.
+
+ Select object and read it:
+ void* obj = QueueSet_select(&qset);
+ if(obj == &que)
+     Queue_read(&que, buff);
+ else if(obj == &sem)
+     Semaphore_take(&sem);
+ */
+void* QueueSet_select(struct QueueSet_t* o)
+{
+    len_t i;
+
+    for(i = 0; i < o->Num; ++i)
+    {
+        if(_QueueSet_ready(&o->Members[i]) != 0)
+        {
+            return o->Members[i].Object;
+        }
+    }
+
+    return NULL;
+}
+
+/** Select object or pend on queue set.
+
+ Try select an object of the queue set; pend on it if none is ready.
+
+ Can be called only by tasks.
+
+ If the task pends it will not run until one of the objects can be read, taken
+ or locked, or the timeout expires.
+
+ @param ticksToWait Number of ticks the task will wait for the queue set
+ (timeout). Passing MAX_DELAY the task will not wakeup by timeout.
+ @return Pointer to the object, NULL if none is ready.
+
+ Select object or pend on queue set without timeout:
+ QueueSet_selectPend(&qset, MAX_DELAY)
+
+ Select object or pend on queue set with timeout of 10 ticks:
+ QueueSet_selectPend(&qset, 10)
+ */
+void* QueueSet_selectPend(struct QueueSet_t* o, tick_t ticksToWait)
+{
+    void* val = QueueSet_select(o);
+    if(val == NULL)
+    {
+        QueueSet_pend(o, ticksToWait);
+    }
+    return val;
+}
+
+/** Pend on queue set.
+
+ Can be called only by tasks.
+
+ The task will not run until one of the objects can be read, taken or locked,
+ or the timeout expires. The task pends on the event list of every object of
+ the queue set, and the first object to unblock it removes it from the others.
+
+ @param ticksToWait Number of ticks the task will wait for the queue set
+ (timeout). Passing MAX_DELAY the task will not wakeup by timeout.
+
+ Pend on queue set without timeout:
+ QueueSet_pend(&qset, MAX_DELAY)
+
+ Pend on queue set with timeout of 10 ticks:
+ QueueSet_pend(&qset, 10)
+ */
+void QueueSet_pend(struct QueueSet_t* o, tick_t ticksToWait)
+{
+    if(ticksToWait != 0U)
+    {
+        struct task_t* task = OS_getCurrentTask();
+
+        OS_schedulerLock();
+        INTERRUPTS_DISABLE();
+        if(QueueSet_select(o) == NULL)
+        {
+            bool_t unblocked = 0;
+            len_t i;
+
+            /* Put the member nodes on the head position in the event lists.
+             So the task may be unblocked by an interrupt. */
+            for(i = 0; i < o->Num; ++i)
+            {
+                struct QueueSetMember_t* member = &o->Members[i];
+                struct taskHeadList_t* list = _QueueSet_list(member);
+
+                ASSERT(member->NodeEvent.List == NULL);
+
+                member->NodeEvent.Owner = task;
+                OS_listInsertAfter(list, (struct taskListNode_t*)list, &member->NodeEvent);
+            }
+
+            task->PendingSet = o;
+
+            /* Move each member node to its position, with interrupts enabled
+             while the event list is walked. */
+            for(i = 0; i < o->Num && unblocked == 0; ++i)
+            {
+                struct QueueSetMember_t* member = &o->Members[i];
+                struct taskHeadList_t* list = _QueueSet_list(member);
+
+                OS_eventPendNode(list, &member->NodeEvent, task->Priority);
+                unblocked = member->NodeEvent.List != list;
+            }
+
+            /* An interrupt may have unblocked the task through a member
+             already in position. */
+            for(i = 0; i < o->Num && unblocked == 0; ++i)
+            {
+                struct QueueSetMember_t* member = &o->Members[i];
+                unblocked = member->NodeEvent.List != _QueueSet_list(member);
+            }
+
+            if(unblocked == 0)
+            {
+                OS_eventBlockTask(task, ticksToWait);
+            }
+            else
+            {
+                /* The scheduler unlock removes the other member nodes. */
+                INTERRUPTS_ENABLE();
+            }
+        }
+        else
+        {
+            INTERRUPTS_ENABLE();
+        }
+        OS_schedulerUnlock();
+    }
+}
+
+#endif /* LIBRERTOS_QUEUESET */
@@ -23,6 +23,12 @@
 
 #if (LIBRERTOS_SOFTWARETIMERS != 0)
 
+#if (LIBRERTOS_TIMER_WHEEL != 0)
+/* Timer wheel slot of a tick. */
+#define TIMER_WHEEL_SLOT(tick) \
+        (&OSstate.TimerWheel[(tick_t)(tick) & (LIBRERTOS_TIMER_WHEEL - 1U)])
+#endif
+
 /* Execute a timer. Used by timer task function. */
 static void _OS_timerExecute(struct Timer_t* timer)
 {
@@ -37,6 +43,21 @@ static void _OS_timerExecute(struct Timer_t* timer)
     function(timer, parameter);
 }
 
+/* Next expiry of a periodic timer, a whole number of periods after its last
+ expiry and after now. The missed periods are counted as overruns. Used by timer
+ task function. */
+static tick_t _OS_timerNextPeriod(struct Timer_t* timer, tick_t now)
+{
+    tick_t expiry = timer->NodeTimer.Value;
+    tick_t missed = (tick_t)((tick_t)(now - expiry) / timer->Period);
+
+    timer->Overruns = (len_t)(timer->Overruns + missed);
+
+    return (tick_t)(expiry + (tick_t)((tick_t)(missed + 1U) * timer->Period));
+}
+
+#if (LIBRERTOS_TIMER_WHEEL == 0)
+
 /* Insert timer into ordered list. Used by timer task function. */
 static void _OS_timerInsertInOrderedList(struct Timer_t* timer, tick_t tickToWakeup)
 {
@@ -124,20 +145,18 @@ static void _OS_timerInsertInOrderedList(struct Timer_t* timer, tick_t tickToWak
 static void _OS_timerFunction(taskParameter_t param)
 {
     uint8_t changeIndex;
+    tick_t now = OS_getTickCount();
     (void)param;
 
+    if(now >= OSstate.TaskTimerLastRun)
     {
-        tick_t now = OS_getTickCount();
-        if(now >= OSstate.TaskTimerLastRun)
-        {
-            OSstate.TaskTimerLastRun = now;
-            changeIndex = 0;
-        }
-        else
-        {
-            OSstate.TaskTimerLastRun = MAX_DELAY;
-            changeIndex = 1;
-        }
+        OSstate.TaskTimerLastRun = now;
+        changeIndex = 0;
+    }
+    else
+    {
+        OSstate.TaskTimerLastRun = MAX_DELAY;
+        changeIndex = 1;
     }
 
     INTERRUPTS_DISABLE();
@@ -180,6 +199,29 @@ static void _OS_timerFunction(taskParameter_t param)
         {
             Timer_reset(timer);
         }
+        else if(timer->Type == TIMERTYPE_PERIODIC)
+        {
+            /* Insert timer into ordered list, a period after its expiry. The
+             missed periods are counted from now, not from the last run, which
+             is MAX_DELAY when the tick has wrapped. */
+            tick_t tickToWakeup = _OS_timerNextPeriod(timer, now);
+            INTERRUPTS_DISABLE();
+            if(node->List == &OSstate.TimerList)
+            {
+                /* Not reset by an interrupt. */
+                OS_listRemove(node);
+                OS_listInsertAfter(
+                        &OSstate.TimerUnorderedList,
+                        (struct taskListNode_t*)&OSstate.TimerUnorderedList,
+                        node);
+                INTERRUPTS_ENABLE();
+                _OS_timerInsertInOrderedList(timer, tickToWakeup);
+            }
+            else
+            {
+                INTERRUPTS_ENABLE();
+            }
+        }
         else
         {
             INTERRUPTS_DISABLE();
@@ -244,6 +286,256 @@ static void _OS_timerFunction(taskParameter_t param)
     }
 }
 
+#else /* LIBRERTOS_TIMER_WHEEL */
+
+/* Insert timer into the wheel, to expire at tick tickToWakeup, and keep the
+ earliest expiry. Must be called with interrupts disabled. Used by timer task
+ function. */
+static void _OS_timerInsertInWheel(struct Timer_t* timer, tick_t tickToWakeup)
+{
+    struct taskListNode_t*const node = &timer->NodeTimer;
+    struct taskHeadList_t*const list = TIMER_WHEEL_SLOT(tickToWakeup);
+
+    node->Value = tickToWakeup;
+    OS_listInsertAfter(list, list->Tail, node);
+
+    if(     OSstate.TimerWheelLength == 0 ||
+            (tick_t)(tickToWakeup - OSstate.TaskTimerLastRun - 1U) <
+            (tick_t)(OSstate.TimerWheelNext - OSstate.TaskTimerLastRun - 1U))
+    {
+        OSstate.TimerWheelNext = tickToWakeup;
+    }
+    ++OSstate.TimerWheelLength;
+}
+
+/* Find the earliest expiry in the wheel, after the timer task has reached the
+ previous one. Walk the slots in expiry order and stop at the first timer that
+ expires in this turn of the wheel. Used by timer task function. */
+static void _OS_timerWheelUpdateNext(tick_t now)
+{
+    /* Ticks to the earliest expiry minus one. */
+    tick_t next = MAX_DELAY;
+    tick_t i;
+
+    for(i = 1; i <= LIBRERTOS_TIMER_WHEEL && i <= next; ++i)
+    {
+        struct taskHeadList_t*const list = TIMER_WHEEL_SLOT(now + i);
+        struct taskListNode_t* node;
+
+        INTERRUPTS_DISABLE();
+
+        for(node = list->Head; node != (struct taskListNode_t*)list; node = node->Next)
+        {
+            tick_t ticksToWakeup = (tick_t)(node->Value - now - 1U);
+            if(ticksToWakeup < next)
+            {
+                next = ticksToWakeup;
+            }
+        }
+
+        INTERRUPTS_ENABLE();
+    }
+
+    OSstate.TimerWheelNext = (tick_t)(now + next + 1U);
+}
+
+/* Move the timers that expired in (TaskTimerLastRun, now] to the list of
+ expired timers. Nothing to do before the earliest expiry, otherwise each wheel
+ slot is visited at most once. Used by timer task function. */
+static void _OS_timerCollectExpired(tick_t now)
+{
+    tick_t lastRun = OSstate.TaskTimerLastRun;
+    tick_t elapsed = (tick_t)(now - lastRun);
+    tick_t i;
+
+    OSstate.TaskTimerLastRun = now;
+
+    if(     OSstate.TimerWheelLength == 0 ||
+            (tick_t)(OSstate.TimerWheelNext - lastRun - 1U) >= elapsed)
+    {
+        /* No timer expired. */
+        return;
+    }
+
+    for(i = 1; i <= elapsed && i <= LIBRERTOS_TIMER_WHEEL; ++i)
+    {
+        struct taskHeadList_t*const list = TIMER_WHEEL_SLOT(lastRun + i);
+        struct taskListNode_t* node;
+
+        INTERRUPTS_DISABLE();
+
+        node = list->Head;
+        while(node != (struct taskListNode_t*)list)
+        {
+            struct taskListNode_t* next = node->Next;
+
+            if((tick_t)(node->Value - lastRun - 1U) < elapsed)
+            {
+                /* Expired. */
+                OS_listRemove(node);
+                --OSstate.TimerWheelLength;
+                OS_listInsertAfter(
+                        &OSstate.TimerExpiredList,
+                        OSstate.TimerExpiredList.Tail,
+                        node);
+            }
+
+            node = next;
+        }
+
+        INTERRUPTS_ENABLE();
+    }
+
+    _OS_timerWheelUpdateNext(now);
+}
+
+/* Timer task function. Used by timer task create function. */
+static void _OS_timerFunction(taskParameter_t param)
+{
+    tick_t now = OS_getTickCount();
+    listlen_t num;
+    (void)param;
+
+    INTERRUPTS_DISABLE();
+
+    /* Insert reset timers into the wheel, a period after now, as the ordered
+     list does; execute one-shot timers. Timers reset by the timer functions
+     with no period run in the next time the timer task runs. */
+    num = OSstate.TimerUnorderedList.Length;
+    while(num != 0 && OSstate.TimerUnorderedList.Length != 0)
+    {
+        struct taskListNode_t* node = OSstate.TimerUnorderedList.Head;
+        struct Timer_t* timer = (struct Timer_t*)node->Owner;
+
+        OS_listRemove(node);
+
+        if(timer->Type == TIMERTYPE_NOPERIOD)
+        {
+            /* Execute one-shot timer. */
+            INTERRUPTS_ENABLE();
+            _OS_timerExecute(timer);
+        }
+        else
+        {
+            if(timer->Period == 0)
+            {
+                /* Expired now. */
+                OS_listInsertAfter(
+                        &OSstate.TimerExpiredList,
+                        OSstate.TimerExpiredList.Tail,
+                        node);
+            }
+            else
+            {
+                /* Insert timer into the wheel. Constant time. */
+                _OS_timerInsertInWheel(timer, (tick_t)(now + timer->Period));
+            }
+            INTERRUPTS_ENABLE();
+        }
+
+        --num;
+        INTERRUPTS_DISABLE();
+    }
+
+    INTERRUPTS_ENABLE();
+
+    _OS_timerCollectExpired(now);
+
+    INTERRUPTS_DISABLE();
+
+    /* Execute expired timers. Auto timers reset by the timer task go to the
+     reset timers list, not to this list. */
+    while(OSstate.TimerExpiredList.Length != 0)
+    {
+        struct taskListNode_t* node = OSstate.TimerExpiredList.Head;
+        struct Timer_t* timer = (struct Timer_t*)node->Owner;
+
+        OS_listRemove(node);
+
+        if(timer->Type == TIMERTYPE_AUTO)
+        {
+            INTERRUPTS_ENABLE();
+            Timer_reset(timer);
+        }
+        else if(timer->Type == TIMERTYPE_PERIODIC)
+        {
+            /* Insert timer into the wheel, a period after its expiry. */
+            _OS_timerInsertInWheel(timer, _OS_timerNextPeriod(timer, now));
+            INTERRUPTS_ENABLE();
+        }
+        else
+        {
+            INTERRUPTS_ENABLE();
+        }
+
+        /* Execute timer. */
+        _OS_timerExecute(timer);
+
+        INTERRUPTS_DISABLE();
+    }
+
+    if(OSstate.TimerUnorderedList.Length == 0)
+    {
+        /* No timer is ready. Block timer task until the earliest expiry. */
+        tick_t ticksToSleep;
+
+        OS_schedulerLock();
+
+        if(OSstate.TimerWheelLength != 0)
+        {
+            ticksToSleep = (tick_t)(OSstate.TimerWheelNext - OS_getTickCount());
+            INTERRUPTS_ENABLE();
+        }
+        else
+        {
+            ticksToSleep = MAX_DELAY;
+            INTERRUPTS_ENABLE();
+        }
+
+        if((difftick_t)ticksToSleep > 0 || ticksToSleep == MAX_DELAY)
+        {
+            /* Delay task only if timer wakeup time is not in the past. */
+            OS_taskDelay(ticksToSleep);
+        }
+
+        OS_schedulerUnlock();
+    }
+    else
+    {
+        /* A timer is ready. Run timer task again. */
+        INTERRUPTS_ENABLE();
+    }
+}
+
+#endif /* LIBRERTOS_TIMER_WHEEL */
+
+/* Remove a running timer from its list. Must be called with interrupts
+ disabled. Used by reset and stop functions. */
+static void _OS_timerRemove(struct Timer_t* timer)
+{
+    struct taskListNode_t*const node = &timer->NodeTimer;
+
+    #if (LIBRERTOS_TIMER_WHEEL == 0)
+    {
+        if(OSstate.TimerIndex == node)
+        {
+            OSstate.TimerIndex = OSstate.TimerIndex->Next;
+        }
+    }
+    #else
+    {
+        if(     node->List != &OSstate.TimerUnorderedList &&
+                node->List != &OSstate.TimerExpiredList)
+        {
+            /* Timer is in the wheel. The earliest expiry is kept. */
+            --OSstate.TimerWheelLength;
+        }
+    }
+    #endif
+
+    OS_listRemove(node);
+}
+
 /** Create timer task.  */
 void OS_timerTaskCreate(priority_t priority)
 {
@@ -254,8 +546,8 @@ void OS_timerTaskCreate(priority_t priority)
 
  This function does not start the timer.
 
- The types can be of three types: TIMERTYPE_ONESHOT, TIMERTYPE_AUTO or
- TIMERTYPE_NOPERIOD.
+ The types can be of four types: TIMERTYPE_ONESHOT, TIMERTYPE_AUTO,
+ TIMERTYPE_PERIODIC or TIMERTYPE_NOPERIOD.
 
  An one-shot timer will run once after its period has timed-out after a reset or
  start.
@@ -263,13 +555,18 @@ void OS_timerTaskCreate(priority_t priority)
  An auto timer will run multiple times after after a reset or start. The auto
  timer resets itself when it runs.
 
+ A periodic timer is an auto timer that does not drift. Its next run is a
+ period after its last expiry, not after it has run. If the timer task is late
+ more than a period the missed periods are skipped and counted as overruns
+ (Timer_getOverruns()). The period must not be zero.
+
  A no-period timer will run once when the timer task is scheduled. It is
  equivalent to a timer with period equal to zero, but avoids being inserted into
  the ordered timers list. It does not use the period information, but user
  should initialize with value 0 as its period.
 
  @param type Define the type of the timer. The types can be TIMERTYPE_ONESHOT,
- TIMERTYPE_AUTO or TIMERTYPE_NOPERIOD.
+ TIMERTYPE_AUTO, TIMERTYPE_PERIODIC or TIMERTYPE_NOPERIOD.
  @param period Period of the timer. After a reset or start the timer will run
  only after its period has timed-out.
  @param function Function pointer to the timer function. It will be called by
@@ -284,10 +581,13 @@ void Timer_init(
         timerFunction_t function,
         timerParameter_t parameter)
 {
+    ASSERT(type != TIMERTYPE_PERIODIC || period != 0);
+
     timer->Type = type;
     timer->Period = period;
     timer->Function = function;
     timer->Parameter = parameter;
+    timer->Overruns = 0;
     OS_listNodeInit(&timer->NodeTimer, timer);
 }
 
@@ -319,13 +619,7 @@ void Timer_reset(struct Timer_t* timer)
     if(timer->NodeTimer.List != NULL)
     {
         /* If timer is running. */
-
-        if(OSstate.TimerIndex == &timer->NodeTimer)
-        {
-            OSstate.TimerIndex = OSstate.TimerIndex->Next;
-        }
-
-        OS_listRemove(&timer->NodeTimer);
+        _OS_timerRemove(timer);
     }
 
     OS_listInsertAfter(
@@ -350,13 +644,7 @@ void Timer_stop(struct Timer_t* timer)
     if(timer->NodeTimer.List != NULL)
     {
         /* If timer is running. */
-
-        if(OSstate.TimerIndex == &timer->NodeTimer)
-        {
-            OSstate.TimerIndex = OSstate.TimerIndex->Next;
-        }
-
-        OS_listRemove(&timer->NodeTimer);
+        _OS_timerRemove(timer);
     }
 
     CRITICAL_EXIT();
@@ -380,4 +668,21 @@ bool_t Timer_isRunning(const struct Timer_t* timer)
     return x;
 }
 
+/** Get overruns of a periodic timer.
+
+ @return Number of periods the timer missed (the timer task was late more than
+ a period) since it was initialized.
+ */
+len_t Timer_getOverruns(const struct Timer_t* timer)
+{
+    len_t x;
+    CRITICAL_VAL();
+    CRITICAL_ENTER();
+
+    x = timer->Overruns;
+
+    CRITICAL_EXIT();
+    return x;
+}
+
 #endif